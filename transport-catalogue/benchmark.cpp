@@ -0,0 +1,509 @@
+#include "benchmark.h"
+
+#include "json_arena.h"
+#include "json_builder.h"
+#include "json_reader.h"
+#include "json_scan.h"
+#include "json_tape.h"
+#include "json_writer.h"
+#include "request_handler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace benchmark {
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Каждый вариант повторяется, пока не наберётся столько времени
+const auto MIN_DURATION = 500ms;
+
+double ToMilliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// Повторяет pass, пока не истечёт MIN_DURATION; возвращает число повторов и время
+template <typename Pass>
+std::pair<size_t, Clock::duration> Repeat(Pass pass) {
+    size_t passes = 0;
+    const auto start = Clock::now();
+    Clock::duration elapsed{};
+    while (elapsed < MIN_DURATION) {
+        pass();
+        ++passes;
+        elapsed = Clock::now() - start;
+    }
+    return { passes, elapsed };
+}
+
+void PrintRenderTimings(std::ostream& output, size_t threads_count, const renderer::RenderTimings& timings) {
+    output << "threads "sv << threads_count
+           << ": prepare "sv << ToMilliseconds(timings.prepare)
+           << " ms, route_lines "sv << ToMilliseconds(timings.route_lines)
+           << " ms, bus_labels "sv << ToMilliseconds(timings.bus_labels)
+           << " ms, stop_symbols "sv << ToMilliseconds(timings.stop_symbols)
+           << " ms, stop_labels "sv << ToMilliseconds(timings.stop_labels)
+           << " ms, concatenation "sv << ToMilliseconds(timings.concatenation)
+           << " ms, total "sv << ToMilliseconds(timings.total) << " ms\n"sv;
+}
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/*
+ * Проходит текст так же, как разборщик: пропускает пробелы, тела строк и цифры,
+ * остальные символы по одному. Возвращает контрольную сумму границ участков,
+ * чтобы сравнить реализации между собой
+ */
+size_t Walk(const json::scan::Kernels& kernels, const char* first, const char* last) {
+    size_t checksum = 0;
+    const char* pos = first;
+    while (pos != last) {
+        const char c = *pos++;
+        if (IsSpace(c)) {
+            pos = kernels.skip_spaces(pos, last);
+        }
+        else if (c == '"') {
+            pos = kernels.skip_string_body(pos, last);
+        }
+        else if (IsDigit(c)) {
+            pos = kernels.skip_digits(pos, last);
+        }
+        else {
+            continue;
+        }
+        checksum = checksum * 31 + static_cast<size_t>(pos - first);
+    }
+    return checksum;
+}
+
+// Тот же проход с циклами, которые были в разборщике до ядер json::scan
+size_t WalkInline(const char* first, const char* last) {
+    size_t checksum = 0;
+    const char* pos = first;
+    while (pos != last) {
+        const char c = *pos++;
+        if (IsSpace(c)) {
+            while (pos != last && IsSpace(*pos)) {
+                ++pos;
+            }
+        }
+        else if (c == '"') {
+            while (pos != last && *pos != '"' && *pos != '\\' && *pos != '\n' && *pos != '\r') {
+                ++pos;
+            }
+        }
+        else if (IsDigit(c)) {
+            while (pos != last && IsDigit(*pos)) {
+                ++pos;
+            }
+        }
+        else {
+            continue;
+        }
+        checksum = checksum * 31 + static_cast<size_t>(pos - first);
+    }
+    return checksum;
+}
+
+/*
+ * Читает из документа то же, что process_requests: настройки сериализации
+ * и поля type, id и name каждого запроса. Возвращает сумму id для сверки
+ */
+template <typename Node>
+int64_t ReadRequests(const Node& root) {
+    const auto& root_dict = root.AsDict();
+    int64_t checksum = static_cast<int64_t>(root_dict.at("serialization_settings").AsDict().size());
+    if (const auto it = root_dict.find("stat_requests"); it != root_dict.end()) {
+        for (const auto& request : it->second.AsArray()) {
+            const auto& request_dict = request.AsDict();
+            checksum += request_dict.at("id").AsInt();
+            checksum += static_cast<int64_t>(request_dict.at("type").AsString().size());
+            if (const auto name = request_dict.find("name"); name != request_dict.end()) {
+                checksum += static_cast<int64_t>(name->second.AsString().size());
+            }
+        }
+    }
+    return checksum;
+}
+
+// Остановки и расстояния из base_requests, без маршрутов
+template <typename Reader>
+void AddStops(const Reader& reader, const std::vector<typename Reader::Dict>& stops, TransportCatalogue& db) {
+    for (const auto& request : stops) {
+        const auto [stop_name, coordinates, distances] = reader.FillStop(request);
+        db.AddStop(stop_name, coordinates);
+    }
+    reader.FillStopDistances(db);
+}
+
+} // namespace
+
+void RunScanBenchmark(std::istream& input, std::ostream& output) {
+    const std::string text{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    const char* first = text.data();
+    const char* last = first + text.size();
+
+    const auto report = [&](std::string_view name, size_t passes, Clock::duration time) {
+        const double seconds = std::chrono::duration<double>(time).count() / passes;
+        output << name << ": "sv << ToMilliseconds(time) / passes << " ms, "sv
+               << text.size() / seconds / 1e6 << " MB/s\n"sv;
+    };
+
+    output << text.size() << " bytes, dispatched kernel "sv << json::scan::GetKernelName() << '\n';
+    size_t expected = 0;
+    const auto [inline_passes, inline_time] = Repeat([&] {
+        expected = WalkInline(first, last);
+    });
+    report("inline loops"sv, inline_passes, inline_time);
+
+    for (const auto& kernels : json::scan::GetSupportedKernels()) {
+        size_t checksum = 0;
+        const auto [passes, time] = Repeat([&] {
+            checksum = Walk(kernels, first, last);
+        });
+        report(kernels.name, passes, time);
+        if (checksum != expected) {
+            throw std::logic_error("Scan kernel "s + std::string(kernels.name) + " differs from inline loops"s);
+        }
+    }
+
+    // Разбор целиком с выбранной реализацией, без построения дерева
+    class NullHandler final : public json::Handler {
+    public:
+        void Null() override {}
+        void Bool(bool) override {}
+        void Int(int) override {}
+        void Double(double) override {}
+        void String(std::string_view) override {}
+        void Key(std::string_view) override {}
+        void StartArray() override {}
+        void EndArray() override {}
+        void StartDict() override {}
+        void EndDict() override {}
+    } handler;
+    const auto [parse_passes, parse_time] = Repeat([&] {
+        json::Parse(std::string_view(text), handler);
+    });
+    report("json::Parse"sv, parse_passes, parse_time);
+}
+
+void RunDocumentBenchmark(std::istream& input, std::ostream& output) {
+    const std::string text{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    output << text.size() << " bytes\n"sv;
+
+    const auto report = [&](std::string_view name, size_t passes, Clock::duration time, size_t size) {
+        output << name << ": "sv << ToMilliseconds(time) / passes << " ms"sv;
+        if (size != 0) {
+            output << ", "sv << size << " bytes"sv;
+        }
+        output << '\n';
+    };
+
+    // Загрузка: текст копируется в каждом проходе, как при чтении из потока
+    const auto [load_passes, load_time] = Repeat([&] {
+        json::Load(std::string_view(text));
+    });
+    report("json::Load"sv, load_passes, load_time, 0);
+    size_t arena_size = 0;
+    const auto [arena_passes, arena_time] = Repeat([&] {
+        arena_size = json::LoadArena(text).GetArenaSize();
+    });
+    report("LoadArena"sv, arena_passes, arena_time, arena_size);
+    size_t tape_size = 0;
+    const auto [tape_passes, tape_time] = Repeat([&] {
+        tape_size = json::LoadTape(text).GetTapeSize();
+    });
+    report("LoadTape"sv, tape_passes, tape_time, tape_size);
+
+    // Загрузка вместе с чтением запросов, как в process_requests
+    const json::Document document = json::Load(std::string_view(text));
+    if (!document.GetRoot().IsDict() || !document.GetRoot().AsDict().count("serialization_settings"s)) {
+        output << "no serialization_settings, request reading is skipped\n"sv;
+        return;
+    }
+    const int64_t expected = ReadRequests(document.GetRoot());
+    int64_t load_checksum = 0;
+    const auto [load_read_passes, load_read_time] = Repeat([&] {
+        load_checksum = ReadRequests(json::Load(std::string_view(text)).GetRoot());
+    });
+    report("json::Load + requests"sv, load_read_passes, load_read_time, 0);
+    int64_t arena_checksum = 0;
+    const auto [arena_read_passes, arena_read_time] = Repeat([&] {
+        arena_checksum = ReadRequests(json::LoadArena(text).GetRoot());
+    });
+    report("LoadArena + requests"sv, arena_read_passes, arena_read_time, 0);
+    int64_t tape_checksum = 0;
+    const auto [tape_read_passes, tape_read_time] = Repeat([&] {
+        tape_checksum = ReadRequests(json::LoadTape(text).GetRoot());
+    });
+    report("LoadTape + requests"sv, tape_read_passes, tape_read_time, 0);
+    if (load_checksum != expected || arena_checksum != expected || tape_checksum != expected) {
+        throw std::logic_error("Documents disagree on stat_requests"s);
+    }
+}
+
+void RunCatalogueBenchmark(std::istream& input, std::ostream& output) {
+    JsonReader reader(input);
+    std::vector<JsonReader::Dict> stops;
+    std::vector<JsonReader::Dict> buses;
+    for (const auto& request : reader.GetBaseRequests().AsArray()) {
+        const auto& type = request.AsDict().at("type").AsString();
+        if (type == "Stop"sv) {
+            stops.push_back(request.AsDict());
+        }
+        else if (type == "Bus"sv) {
+            buses.push_back(request.AsDict());
+        }
+    }
+    output << stops.size() << " stops, "sv << buses.size() << " buses\n"sv;
+
+    TransportCatalogue stops_only;
+    const auto [stops_passes, stops_time] = Repeat([&] {
+        TransportCatalogue db;
+        AddStops(reader, stops, db);
+        stops_only = std::move(db);
+    });
+    output << "stops and distances: "sv << ToMilliseconds(stops_time) / stops_passes << " ms\n"sv;
+
+    // Маршруты по одному через AddRoute против AddRoutes, как в FillCatalogue
+    TransportCatalogue single;
+    const auto [single_passes, single_time] = Repeat([&] {
+        TransportCatalogue db;
+        AddStops(reader, stops, db);
+        for (const auto& request : buses) {
+            const auto [bus_name, route, is_circle] = reader.FillRoute(request, db);
+            db.AddRoute(bus_name, route, is_circle);
+        }
+        single = std::move(db);
+    });
+    output << "stops, distances and AddRoute: "sv << ToMilliseconds(single_time) / single_passes << " ms\n"sv;
+    TransportCatalogue bulk;
+    const auto [bulk_passes, bulk_time] = Repeat([&] {
+        TransportCatalogue db;
+        AddStops(reader, stops, db);
+        std::vector<std::tuple<std::string_view, std::vector<StopPtr>, bool>> routes;
+        for (const auto& request : buses) {
+            routes.push_back(reader.FillRoute(request, db));
+        }
+        db.AddRoutes(routes);
+        bulk = std::move(db);
+    });
+    output << "stops, distances and AddRoutes: "sv << ToMilliseconds(bulk_time) / bulk_passes << " ms\n"sv;
+
+    /*
+     * Прежний AddRoute искал каждую остановку маршрута перебором всех остановок
+     * справочника по имени. Здесь тот же перебор строит список маршрутов остановок
+     * отдельно от справочника; время квадратично, на больших входах это секунды
+     */
+    std::vector<std::set<std::string_view>> scanned;
+    const auto [scan_passes, scan_time] = Repeat([&] {
+        scanned.assign(bulk.GetStopCount(), {});
+        for (size_t bus_id = 0; bus_id < bulk.GetBusCount(); ++bus_id) {
+            const BusPtr bus = bulk.GetBusById(static_cast<BusId>(bus_id));
+            for (const auto route_stop : bus->stops) {
+                for (size_t stop_id = 0; stop_id < bulk.GetStopCount(); ++stop_id) {
+                    if (bulk.GetStopById(static_cast<StopId>(stop_id))->name == route_stop->name) {
+                        scanned[stop_id].insert(bus->name);
+                    }
+                }
+            }
+        }
+    });
+    output << "stop-to-bus links by scan: "sv << ToMilliseconds(scan_time) / scan_passes << " ms\n"sv;
+
+    for (size_t stop_id = 0; stop_id < bulk.GetStopCount(); ++stop_id) {
+        const auto& expected = bulk.GetStopById(static_cast<StopId>(stop_id))->buses_by_stop;
+        if (single.GetStopById(static_cast<StopId>(stop_id))->buses_by_stop != expected || scanned[stop_id] != expected) {
+            throw std::logic_error("Stop-to-bus links differ between loading paths"s);
+        }
+    }
+
+    // Finalize сам замеряет своё время; статистика не должна зависеть от числа потоков
+    const size_t threads_count = std::max(2u, std::thread::hardware_concurrency());
+    std::vector<BusStat> sequential;
+    for (const size_t threads : { size_t{ 1 }, threads_count }) {
+        bulk.Finalize(threads);
+        output << "Finalize, threads "sv << threads << ": "sv << ToMilliseconds(bulk.GetFinalizeDuration()) << " ms\n"sv;
+        for (size_t bus_id = 0; bus_id < bulk.GetBusCount(); ++bus_id) {
+            const auto stat = *bulk.GetRouteStatistics(bulk.GetBusById(static_cast<BusId>(bus_id))->name);
+            if (threads == 1) {
+                sequential.push_back(stat);
+            }
+            else if (stat.route_length != sequential[bus_id].route_length || stat.curvature != sequential[bus_id].curvature
+                     || stat.stops_count != sequential[bus_id].stops_count
+                     || stat.unique_stops_count != sequential[bus_id].unique_stops_count) {
+                throw std::logic_error("Parallel Finalize differs from sequential"s);
+            }
+        }
+    }
+}
+
+void RunBuilderBenchmark(std::istream& input, std::ostream& output) {
+    TransportCatalogue db;
+    JsonReader reader(input, db);
+    db.Finalize();
+    // Карта в замере не рисуется, настройки отрисовки не нужны
+    const renderer::MapRenderer renderer(renderer::RenderSettings{});
+    const RequestHandler rh(db, renderer);
+
+    // Запросы Map и Route не участвуют: их стоимость — отрисовка и поиск пути
+    std::vector<JsonReader::Dict> requests;
+    for (const auto& request : reader.GetStatRequests().AsArray()) {
+        const auto& type = request.AsDict().at("type").AsString();
+        if (type == "Bus"sv || type == "Stop"sv) {
+            requests.push_back(request.AsDict());
+        }
+    }
+    if (requests.empty()) {
+        output << "no Bus or Stop requests\n"sv;
+        return;
+    }
+
+    size_t builder_size = 0;
+    json::Builder builder;
+    std::ostringstream printed;
+    const auto [builder_passes, builder_time] = Repeat([&] {
+        builder_size = 0;
+        for (const auto& request : requests) {
+            const std::string_view name = request.at("name").AsString();
+            const int id = request.at("id").AsInt();
+            builder.StartDict();
+            if (request.at("type").AsString() == "Bus"sv) {
+                if (rh.IsBusNumber(name)) {
+                    const auto stat = rh.GetBusStat(name);
+                    builder.Key("curvature").Value(stat->curvature)
+                        .Key("request_id").Value(id)
+                        .Key("route_length").Value(stat->route_length)
+                        .Key("stop_count").Value(static_cast<int>(stat->stops_count))
+                        .Key("unique_stop_count").Value(static_cast<int>(stat->unique_stops_count));
+                }
+                else {
+                    builder.Key("error_message").Value("not found"s).Key("request_id").Value(id);
+                }
+            }
+            else if (rh.IsStopName(name)) {
+                builder.Key("buses").StartArray();
+                for (const auto bus : rh.GetBusesByStop(name)) {
+                    builder.Value(std::string(bus));
+                }
+                builder.EndArray().Key("request_id").Value(id);
+            }
+            else {
+                builder.Key("error_message").Value("not found"s).Key("request_id").Value(id);
+            }
+            builder.EndDict();
+            printed.str({});
+            json::Print(json::Document(builder.Build()), printed);
+            builder_size += printed.tellp();
+        }
+    });
+
+    size_t writer_size = 0;
+    std::string response;
+    const auto [writer_passes, writer_time] = Repeat([&] {
+        writer_size = 0;
+        for (const auto& request : requests) {
+            response.clear();
+            json::Writer writer(response);
+            reader.MakeResponse(request, rh, writer);
+            writer_size += response.size();
+        }
+    });
+
+    const auto report = [&](std::string_view name, size_t passes, Clock::duration time, size_t size) {
+        const double responses = static_cast<double>(passes * requests.size());
+        output << name << ": "sv << static_cast<size_t>(responses / std::chrono::duration<double>(time).count())
+               << " responses/s, "sv << ToMilliseconds(time) / passes << " ms per "sv << requests.size()
+               << " responses, "sv << size << " bytes\n"sv;
+    };
+    report("builder"sv, builder_passes, builder_time, builder_size);
+    report("writer"sv, writer_passes, writer_time, writer_size);
+}
+
+void RunRenderBenchmark(std::istream& input, std::ostream& output) {
+    TransportCatalogue db;
+    JsonReader reader(input, db);
+    db.Finalize(std::thread::hardware_concurrency());
+    const auto renderer = reader.FillRenderSettings(reader.GetRenderSettings().AsDict());
+    const auto buses = db.SortBuses();
+
+    // Прежний путь: дерево объектов svg::Document и вывод через std::ostream
+    std::string document;
+    const auto [document_passes, document_time] = Repeat([&] {
+        std::ostringstream out;
+        renderer.RenderSVG(buses).Render(out);
+        document = out.str();
+    });
+    // svg::Document не упрощает линии, поэтому сравнивается карта без упрощения
+    std::string buffer;
+    const auto [buffer_passes, buffer_time] = Repeat([&] {
+        buffer.clear();
+        renderer.RenderSVG(buses, 0.0, buffer);
+    });
+    output << "document: "sv << ToMilliseconds(document_time) / document_passes << " ms, "sv << document.size() << " bytes\n"sv;
+    output << "buffer: "sv << ToMilliseconds(buffer_time) / buffer_passes << " ms, "sv << buffer.size() << " bytes\n"sv;
+    // Компактный вывод есть только у BufferWriter
+    if (!renderer.GetRenderSettings().compact_output && document != buffer) {
+        throw std::logic_error("Buffer map rendering differs from svg::Document");
+    }
+
+    // Карта для ответа Map: отрисовка в строку и её экранирование против
+    // отрисовки через поток прямо в json::EscapingStreamBuf
+    std::string copied;
+    const auto [copied_passes, copied_time] = Repeat([&] {
+        copied.clear();
+        std::string svg;
+        renderer.RenderSVG(buses, svg);
+        json::EscapingStreamBuf escaping(copied);
+        std::ostream out(&escaping);
+        out << svg;
+    });
+    std::string streamed;
+    const auto [streamed_passes, streamed_time] = Repeat([&] {
+        streamed.clear();
+        json::EscapingStreamBuf escaping(streamed);
+        std::ostream out(&escaping);
+        renderer.RenderSVG(buses, out);
+    });
+    output << "escaped via string: "sv << ToMilliseconds(copied_time) / copied_passes << " ms, "sv << copied.size() << " bytes\n"sv;
+    output << "escaped via stream: "sv << ToMilliseconds(streamed_time) / streamed_passes << " ms, "sv << streamed.size() << " bytes\n"sv;
+    if (copied != streamed) {
+        throw std::logic_error("Streamed map rendering differs from buffer");
+    }
+
+    size_t threads_count = reader.GetThreadCount();
+    if (threads_count == 1) {
+        threads_count = std::max(2u, std::thread::hardware_concurrency());
+    }
+    std::string sequential;
+    renderer::RenderTimings timings;
+    renderer.RenderSVG(buses, sequential, 1, &timings);
+    PrintRenderTimings(output, 1, timings);
+
+    std::string parallel;
+    renderer.RenderSVG(buses, parallel, threads_count, &timings);
+    PrintRenderTimings(output, threads_count, timings);
+    if (parallel != sequential) {
+        throw std::logic_error("Parallel map rendering differs from sequential");
+    }
+    output << "map "sv << sequential.size() << " bytes\n"sv;
+}
+
+} // namespace benchmark
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <iostream>
+
+/*
+ * Замеры производительности, доступные как режимы запуска transport_catalogue.
+ * Каждый читает JSON из input (тот же, что и для запуска без аргументов),
+ * сравнивает новую реализацию с прежней на одних и тех же данных
+ * и выводит время в output
+ */
+namespace benchmark {
+
+// Ядра json::scan: побайтовые циклы прежнего разборщика против scalar, sse2 и avx2,
+// затем json::Parse целиком с выбранной реализацией
+void RunScanBenchmark(std::istream& input, std::ostream& output);
+
+// Загрузка входа: json::Load против json::ArenaDocument и ленты json::TapeDocument,
+// отдельно и вместе с чтением запросов, как в process_requests
+void RunDocumentBenchmark(std::istream& input, std::ostream& output);
+
+// Наполнение справочника из base_requests: маршруты через AddRoute и AddRoutes,
+// затем связи остановок с маршрутами перебором всех остановок, как до индекса по имени,
+// и время Finalize в один поток и параллельно
+void RunCatalogueBenchmark(std::istream& input, std::ostream& output);
+
+// Ответы на запросы Bus и Stop: json::Builder с json::Print против json::Writer
+void RunBuilderBenchmark(std::istream& input, std::ostream& output);
+
+// Отрисовка полной карты: svg::Document против svg::BufferWriter, экранирование
+// карты для ответа через строку и через поток, затем BufferWriter в один поток
+// и параллельно с временем каждого слоя
+void RunRenderBenchmark(std::istream& input, std::ostream& output);
+
+} // namespace benchmark
@@ -0,0 +1,102 @@
+#include "distance_table.h"
+
+#include <algorithm>
+
+namespace transport_catalogue {
+
+void DistanceTable::Set(StopId from, StopId to, int distance) {
+    if ((used_ + 2) * 2 > slots_.size()) {
+        Grow();
+    }
+    adjacency_offsets_.clear();
+    adjacency_.clear();
+
+    Slot& direct = slots_[FindSlot(MakeKey(from, to))];
+    if (direct.key == EMPTY_KEY) {
+        direct.key = MakeKey(from, to);
+        ++used_;
+    }
+    if (!direct.is_explicit) {
+        direct.is_explicit = true;
+        ++explicit_count_;
+    }
+    direct.distance = distance;
+
+    Slot& reverse = slots_[FindSlot(MakeKey(to, from))];
+    if (reverse.key == EMPTY_KEY) {
+        reverse.key = MakeKey(to, from);
+        ++used_;
+    }
+    if (!reverse.is_explicit) {
+        reverse.distance = distance;
+    }
+}
+
+int DistanceTable::Get(StopId from, StopId to) const {
+    if (slots_.empty()) {
+        return 0;
+    }
+    return slots_[FindSlot(MakeKey(from, to))].distance;
+}
+
+size_t DistanceTable::Size() const {
+    return explicit_count_;
+}
+
+void DistanceTable::BuildAdjacency(size_t stop_count) {
+    adjacency_offsets_.assign(stop_count + 1, 0);
+    for (const Slot& slot : slots_) {
+        if (slot.key != EMPTY_KEY) {
+            ++adjacency_offsets_[(slot.key >> 32) + 1];
+        }
+    }
+    for (size_t i = 1; i < adjacency_offsets_.size(); ++i) {
+        adjacency_offsets_[i] += adjacency_offsets_[i - 1];
+    }
+
+    adjacency_.resize(adjacency_offsets_.back());
+    std::vector<uint32_t> positions(adjacency_offsets_.begin(), adjacency_offsets_.end() - 1);
+    for (const Slot& slot : slots_) {
+        if (slot.key != EMPTY_KEY) {
+            const StopId from = static_cast<StopId>(slot.key >> 32);
+            adjacency_[positions[from]++] = { static_cast<StopId>(slot.key), slot.distance };
+        }
+    }
+    for (size_t i = 0; i < stop_count; ++i) {
+        std::sort(adjacency_.begin() + adjacency_offsets_[i], adjacency_.begin() + adjacency_offsets_[i + 1],
+                  [](const Neighbour& lhs, const Neighbour& rhs) { return lhs.to < rhs.to; });
+    }
+}
+
+DistanceTable::NeighbourRange DistanceTable::GetNeighbours(StopId from) const {
+    if (static_cast<size_t>(from) + 1 >= adjacency_offsets_.size()) {
+        return {};
+    }
+    return { adjacency_.data() + adjacency_offsets_[from], adjacency_.data() + adjacency_offsets_[from + 1] };
+}
+
+uint64_t DistanceTable::MakeKey(StopId from, StopId to) {
+    return (static_cast<uint64_t>(from) << 32) | to;
+}
+
+size_t DistanceTable::FindSlot(uint64_t key) const {
+    // Размер таблицы — степень двойки, заполнение не больше половины
+    const size_t mask = slots_.size() - 1;
+    size_t index = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (slots_[index].key != key && slots_[index].key != EMPTY_KEY) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+void DistanceTable::Grow() {
+    std::vector<Slot> old_slots = std::move(slots_);
+    slots_.assign(old_slots.empty() ? 64 : old_slots.size() * 2, Slot{});
+    for (const Slot& slot : old_slots) {
+        if (slot.key != EMPTY_KEY) {
+            slots_[FindSlot(slot.key)] = slot;
+        }
+    }
+}
+
+} // namespace transport_catalogue
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace transport_catalogue {
+
+using namespace domain;
+
+/*
+ * Таблица дорожных расстояний между остановками с открытой адресацией.
+ * Ключ — пара StopId, упакованная в uint64_t. Обратное направление
+ * (to -> from) записывается при вставке, если для него нет собственного
+ * значения, поэтому запрос расстояния — это один поиск в таблице.
+ */
+class DistanceTable {
+public:
+    struct Neighbour {
+        StopId to;
+        int distance;
+    };
+
+    struct NeighbourRange {
+        const Neighbour* first = nullptr;
+        const Neighbour* last = nullptr;
+
+        const Neighbour* begin() const { return first; }
+        const Neighbour* end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
+    // Задаёт расстояние from -> to. Для to -> from это же значение
+    // используется, пока для него не задано своё
+    void Set(StopId from, StopId to, int distance);
+
+    // Возвращает расстояние from -> to либо 0, если оно неизвестно
+    int Get(StopId from, StopId to) const;
+
+    // Количество заданных явно пар
+    size_t Size() const;
+
+    // Строит списки соседей в формате CSR. Любой вызов Set сбрасывает их
+    void BuildAdjacency(size_t stop_count);
+
+    // Остановки, расстояние до которых известно, в порядке возрастания StopId
+    NeighbourRange GetNeighbours(StopId from) const;
+
+    // Вызывает func(from, to, distance) для каждой явно заданной пары
+    template <typename Func>
+    void ForEach(Func func) const {
+        for (const Slot& slot : slots_) {
+            if (slot.key != EMPTY_KEY && slot.is_explicit) {
+                func(static_cast<StopId>(slot.key >> 32), static_cast<StopId>(slot.key), slot.distance);
+            }
+        }
+    }
+
+private:
+    static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+    struct Slot {
+        uint64_t key = EMPTY_KEY;
+        int distance = 0;
+        bool is_explicit = false;
+    };
+
+    static uint64_t MakeKey(StopId from, StopId to);
+    size_t FindSlot(uint64_t key) const;
+    void Grow();
+
+    std::vector<Slot> slots_;
+    size_t used_ = 0;
+    size_t explicit_count_ = 0;
+
+    std::vector<uint32_t> adjacency_offsets_;
+    std::vector<Neighbour> adjacency_;
+};
+
+} // namespace transport_catalogue
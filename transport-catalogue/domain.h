@@ -2,6 +2,7 @@
  
 #include "geo.h" 
  
+#include <cstdint> 
 #include <set> 
 #include <string> 
 #include <string_view> 
@@ -12,10 +13,15 @@ namespace transport_catalogue {
  
 namespace domain { 
  
+// Плотные идентификаторы: индекс остановки или маршрута в порядке добавления в справочник 
+using StopId = uint32_t; 
+using BusId = uint32_t; 
+ 
 struct Stop { 
     std::string name; 
     geo::Coordinates coordinates; 
     std::set<std::string_view> buses_by_stop; 
+    StopId id = 0; 
 }; 
 using StopPtr = const Stop*; 
  
@@ -28,9 +34,22 @@ struct Bus {
     std::string name; 
     std::vector<StopPtr> stops; 
     RouteType type = Straight; 
+    BusId id = 0; 
 }; 
 using BusPtr = const Bus*; 
  
+// Непрерывный участок массива идентификаторов остановок (остановки одного маршрута) 
+struct StopIdRange { 
+    const StopId* first = nullptr; 
+    const StopId* last = nullptr; 
+ 
+    const StopId* begin() const { return first; } 
+    const StopId* end() const { return last; } 
+    size_t size() const { return last - first; } 
+    bool empty() const { return first == last; } 
+    StopId operator[](size_t index) const { return first[index]; } 
+}; 
+ 
 struct BusStat { 
     size_t stops_count; 
     size_t unique_stops_count; 
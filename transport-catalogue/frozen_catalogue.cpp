@@ -0,0 +1,423 @@
+#include "frozen_catalogue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FROZEN_CATALOGUE_MMAP
+#endif
+
+namespace transport_catalogue {
+
+// Смещения секций отсчитываются от начала блока
+struct FrozenCatalogue::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t stop_count;
+    uint32_t bus_count;
+    uint64_t stops;
+    uint64_t buses;
+    uint64_t stops_by_name;
+    uint64_t buses_by_name;
+    uint64_t stop_buses;
+    uint64_t route_stops;
+    uint64_t names;
+    uint64_t names_size;
+    uint64_t map;
+    uint64_t map_size;
+    uint64_t size;
+};
+
+struct FrozenCatalogue::StopRecord {
+    double lat;
+    double lng;
+    uint32_t name;
+    uint32_t name_size;
+    uint32_t buses_first;
+    uint32_t buses_count;
+};
+
+struct FrozenCatalogue::BusRecord {
+    uint32_t name;
+    uint32_t name_size;
+    uint32_t stops_first;
+    uint32_t stops_count;
+    uint32_t type;
+    uint32_t stat_stops_count;
+    uint32_t stat_unique_stops_count;
+    uint32_t reserved;
+    double stat_route_length;
+    double stat_curvature;
+};
+
+namespace {
+
+constexpr uint32_t FROZEN_MAGIC = 0x5A525446; // "FTRZ"
+constexpr uint32_t FROZEN_VERSION = 1;
+
+uint64_t Align(uint64_t offset) {
+    return (offset + 7) & ~uint64_t{ 7 };
+}
+
+} // namespace
+
+FrozenCatalogue::FrozenCatalogue(const TransportCatalogue& db, std::string_view rendered_map) {
+    const size_t stop_count = db.GetStopCount();
+    const size_t bus_count = db.GetBusCount();
+
+    std::string names;
+    std::unordered_map<std::string_view, uint32_t> interned;
+    auto intern = [&names, &interned](std::string_view name) {
+        const auto [it, inserted] = interned.emplace(name, static_cast<uint32_t>(names.size()));
+        if (inserted) {
+            names.append(name);
+        }
+        return it->second;
+    };
+
+    std::vector<StopRecord> stops(stop_count);
+    std::vector<uint32_t> stop_buses;
+    for (StopId id = 0; id < stop_count; ++id) {
+        StopPtr stop = db.GetStopById(id);
+        stops[id] = { stop->coordinates.lat, stop->coordinates.lng, intern(stop->name),
+                      static_cast<uint32_t>(stop->name.size()), static_cast<uint32_t>(stop_buses.size()),
+                      static_cast<uint32_t>(stop->buses_by_stop.size()) };
+        for (std::string_view bus_name : stop->buses_by_stop) {
+            stop_buses.push_back(db.GetRoute(bus_name)->id);
+        }
+    }
+
+    std::vector<BusRecord> buses(bus_count);
+    std::vector<uint32_t> route_stops;
+    for (BusId id = 0; id < bus_count; ++id) {
+        BusPtr bus = db.GetBusById(id);
+        const StopIdRange route = db.GetRouteStopIds(id);
+        BusRecord& record = buses[id];
+        record.name = intern(bus->name);
+        record.name_size = static_cast<uint32_t>(bus->name.size());
+        record.stops_first = static_cast<uint32_t>(route_stops.size());
+        record.stops_count = static_cast<uint32_t>(route.size());
+        record.type = bus->type;
+        record.reserved = 0;
+        route_stops.insert(route_stops.end(), route.begin(), route.end());
+
+        const BusStat stat = *db.GetRouteStatistics(bus->name);
+        record.stat_stops_count = static_cast<uint32_t>(stat.stops_count);
+        record.stat_unique_stops_count = static_cast<uint32_t>(stat.unique_stops_count);
+        record.stat_route_length = stat.route_length;
+        record.stat_curvature = stat.curvature;
+    }
+
+    std::vector<uint32_t> stops_by_name(stop_count);
+    std::iota(stops_by_name.begin(), stops_by_name.end(), 0);
+    std::sort(stops_by_name.begin(), stops_by_name.end(), [&db](uint32_t lhs, uint32_t rhs) {
+        return db.GetStopById(lhs)->name < db.GetStopById(rhs)->name;
+    });
+    std::vector<uint32_t> buses_by_name(bus_count);
+    std::iota(buses_by_name.begin(), buses_by_name.end(), 0);
+    std::sort(buses_by_name.begin(), buses_by_name.end(), [&db](uint32_t lhs, uint32_t rhs) {
+        return db.GetBusById(lhs)->name < db.GetBusById(rhs)->name;
+    });
+
+    Header header{};
+    header.magic = FROZEN_MAGIC;
+    header.version = FROZEN_VERSION;
+    header.stop_count = static_cast<uint32_t>(stop_count);
+    header.bus_count = static_cast<uint32_t>(bus_count);
+    header.stops = Align(sizeof(Header));
+    header.buses = Align(header.stops + stops.size() * sizeof(StopRecord));
+    header.stops_by_name = Align(header.buses + buses.size() * sizeof(BusRecord));
+    header.buses_by_name = Align(header.stops_by_name + stops_by_name.size() * sizeof(uint32_t));
+    header.stop_buses = Align(header.buses_by_name + buses_by_name.size() * sizeof(uint32_t));
+    header.route_stops = Align(header.stop_buses + stop_buses.size() * sizeof(uint32_t));
+    header.names = Align(header.route_stops + route_stops.size() * sizeof(uint32_t));
+    header.names_size = names.size();
+    header.map = Align(header.names + names.size());
+    header.map_size = rendered_map.size();
+    header.size = Align(header.map + rendered_map.size());
+
+    storage_.assign(header.size / sizeof(uint64_t), 0);
+    char* data = reinterpret_cast<char*>(storage_.data());
+    auto copy = [data](uint64_t offset, const void* source, size_t size) {
+        if (size > 0) {
+            std::memcpy(data + offset, source, size);
+        }
+    };
+    copy(0, &header, sizeof(Header));
+    copy(header.stops, stops.data(), stops.size() * sizeof(StopRecord));
+    copy(header.buses, buses.data(), buses.size() * sizeof(BusRecord));
+    copy(header.stops_by_name, stops_by_name.data(), stops_by_name.size() * sizeof(uint32_t));
+    copy(header.buses_by_name, buses_by_name.data(), buses_by_name.size() * sizeof(uint32_t));
+    copy(header.stop_buses, stop_buses.data(), stop_buses.size() * sizeof(uint32_t));
+    copy(header.route_stops, route_stops.data(), route_stops.size() * sizeof(uint32_t));
+    copy(header.names, names.data(), names.size());
+    copy(header.map, rendered_map.data(), rendered_map.size());
+}
+
+std::optional<StopId> FrozenCatalogue::FindStop(std::string_view stop_name) const {
+    if (Size() == 0) {
+        return std::nullopt;
+    }
+    const Header& header = GetHeader();
+    const uint32_t* first = GetIds(header.stops_by_name);
+    const uint32_t* last = first + header.stop_count;
+    const uint32_t* it = std::lower_bound(first, last, stop_name, [this](uint32_t id, std::string_view name) {
+        return GetStopName(id) < name;
+    });
+    if (it == last || GetStopName(*it) != stop_name) {
+        return std::nullopt;
+    }
+    return *it;
+}
+
+std::optional<BusId> FrozenCatalogue::FindRoute(std::string_view bus_name) const {
+    if (Size() == 0) {
+        return std::nullopt;
+    }
+    const Header& header = GetHeader();
+    const uint32_t* first = GetIds(header.buses_by_name);
+    const uint32_t* last = first + header.bus_count;
+    const uint32_t* it = std::lower_bound(first, last, bus_name, [this](uint32_t id, std::string_view name) {
+        return GetBusName(id) < name;
+    });
+    if (it == last || GetBusName(*it) != bus_name) {
+        return std::nullopt;
+    }
+    return *it;
+}
+
+std::optional<BusStat> FrozenCatalogue::GetRouteStatistics(const std::string_view& bus_name) const {
+    const auto id = FindRoute(bus_name);
+    if (!id) {
+        throw std::invalid_argument("bus not found");
+    }
+    const BusRecord& record = GetBusRecord(*id);
+    return BusStat{ record.stat_stops_count, record.stat_unique_stops_count,
+                    record.stat_route_length, record.stat_curvature };
+}
+
+std::vector<std::string_view> FrozenCatalogue::GetBusesByStop(const std::string_view& stop_name) const {
+    std::vector<std::string_view> result;
+    const auto id = FindStop(stop_name);
+    if (!id) {
+        return result;
+    }
+    const StopRecord& record = GetStopRecord(*id);
+    const uint32_t* buses = GetIds(GetHeader().stop_buses) + record.buses_first;
+    result.reserve(record.buses_count);
+    for (uint32_t i = 0; i < record.buses_count; ++i) {
+        result.push_back(GetBusName(buses[i]));
+    }
+    return result;
+}
+
+size_t FrozenCatalogue::GetStopCount() const {
+    return Size() == 0 ? 0 : GetHeader().stop_count;
+}
+
+size_t FrozenCatalogue::GetBusCount() const {
+    return Size() == 0 ? 0 : GetHeader().bus_count;
+}
+
+std::string_view FrozenCatalogue::GetStopName(StopId id) const {
+    const StopRecord& record = GetStopRecord(id);
+    return GetName(record.name, record.name_size);
+}
+
+geo::Coordinates FrozenCatalogue::GetStopCoordinates(StopId id) const {
+    const StopRecord& record = GetStopRecord(id);
+    return { record.lat, record.lng };
+}
+
+std::string_view FrozenCatalogue::GetBusName(BusId id) const {
+    const BusRecord& record = GetBusRecord(id);
+    return GetName(record.name, record.name_size);
+}
+
+RouteType FrozenCatalogue::GetRouteType(BusId id) const {
+    return static_cast<RouteType>(GetBusRecord(id).type);
+}
+
+StopIdRange FrozenCatalogue::GetRouteStopIds(BusId id) const {
+    const BusRecord& record = GetBusRecord(id);
+    const uint32_t* first = GetIds(GetHeader().route_stops) + record.stops_first;
+    return { first, first + record.stops_count };
+}
+
+bool FrozenCatalogue::HasRenderedMap() const {
+    return Size() != 0 && GetHeader().map_size > 0;
+}
+
+std::string_view FrozenCatalogue::GetRenderedMap() const {
+    if (!HasRenderedMap()) {
+        throw std::logic_error("Frozen catalogue has no rendered map");
+    }
+    const Header& header = GetHeader();
+    return { Data() + header.map, header.map_size };
+}
+
+size_t FrozenCatalogue::GetMemoryUsage() const {
+    return Size();
+}
+
+FrozenCatalogue FrozenCatalogue::Map(const std::string& path) {
+    FrozenCatalogue result;
+#ifdef FROZEN_CATALOGUE_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open frozen catalogue " + path);
+    }
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Unable to read frozen catalogue " + path);
+    }
+    const size_t size = static_cast<size_t>(file_stat.st_size);
+    void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Unable to map frozen catalogue " + path);
+    }
+    result.mapped_ = std::shared_ptr<const char>(static_cast<const char*>(address), [size](const char* ptr) {
+        munmap(const_cast<char*>(ptr), size);
+    });
+    result.mapped_size_ = size;
+#else
+    // Без mmap файл читается целиком
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Unable to open frozen catalogue " + path);
+    }
+    const std::string buffer{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    result.storage_.assign((buffer.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+    std::memcpy(result.storage_.data(), buffer.data(), buffer.size());
+#endif
+    result.Validate();
+    return result;
+}
+
+void FrozenCatalogue::Save(std::ostream& output) const {
+    output.write(Data(), Size());
+    if (!output) {
+        throw std::runtime_error("Failed to write frozen catalogue");
+    }
+}
+
+const char* FrozenCatalogue::Data() const {
+    return mapped_ ? mapped_.get() : reinterpret_cast<const char*>(storage_.data());
+}
+
+size_t FrozenCatalogue::Size() const {
+    return mapped_ ? mapped_size_ : storage_.size() * sizeof(uint64_t);
+}
+
+void FrozenCatalogue::Validate() const {
+    if (Size() < sizeof(Header)) {
+        throw std::runtime_error("Frozen catalogue is truncated");
+    }
+    const Header& header = GetHeader();
+    if (header.magic != FROZEN_MAGIC) {
+        throw std::runtime_error("Not a frozen catalogue");
+    }
+    if (header.version != FROZEN_VERSION) {
+        throw std::runtime_error("Unsupported frozen catalogue version " + std::to_string(header.version));
+    }
+    if (header.size > Size()) {
+        throw std::runtime_error("Frozen catalogue is truncated");
+    }
+
+    /*
+     * Секции лежат подряд в порядке записи, каждая с выровненного смещения.
+     * Длины stop_buses и route_stops в заголовке не хранятся и определяются
+     * началом следующей секции. Всё, что читают запросы, проверяется здесь один раз,
+     * после чего обращения к блоку не выходят за его границы
+     */
+    const uint64_t offsets[] = {
+        header.stops, header.buses, header.stops_by_name, header.buses_by_name,
+        header.stop_buses, header.route_stops, header.names, header.map, header.size,
+    };
+    if (header.stops < sizeof(Header)
+        || !std::is_sorted(std::begin(offsets), std::end(offsets))
+        || std::any_of(std::begin(offsets), std::end(offsets), [](uint64_t offset) { return offset % 8 != 0; })) {
+        throw std::runtime_error("Frozen catalogue has a corrupted section layout");
+    }
+    // Смещения не превосходят header.size, поэтому суммы ниже не переполняются
+    const uint64_t section_ends[] = {
+        header.stops + uint64_t{ header.stop_count } * sizeof(StopRecord),
+        header.buses + uint64_t{ header.bus_count } * sizeof(BusRecord),
+        header.stops_by_name + uint64_t{ header.stop_count } * sizeof(uint32_t),
+        header.buses_by_name + uint64_t{ header.bus_count } * sizeof(uint32_t),
+        header.names + std::min(header.names_size, header.size),
+        header.map + std::min(header.map_size, header.size),
+    };
+    const uint64_t section_limits[] = {
+        header.buses, header.stops_by_name, header.buses_by_name, header.stop_buses, header.map, header.size,
+    };
+    if (!std::equal(std::begin(section_ends), std::end(section_ends), std::begin(section_limits),
+                    [](uint64_t end, uint64_t limit) { return end <= limit; })) {
+        throw std::runtime_error("Frozen catalogue is truncated");
+    }
+
+    const uint64_t stop_buses_count = (header.route_stops - header.stop_buses) / sizeof(uint32_t);
+    const uint64_t route_stops_count = (header.names - header.route_stops) / sizeof(uint32_t);
+    auto check_range = [](uint64_t first, uint64_t count, uint64_t size) {
+        if (first + count > size) {
+            throw std::runtime_error("Frozen catalogue has a record out of bounds");
+        }
+    };
+    auto check_ids = [this](uint64_t offset, uint64_t count, uint32_t limit) {
+        const uint32_t* ids = GetIds(offset);
+        if (std::any_of(ids, ids + count, [limit](uint32_t id) { return id >= limit; })) {
+            throw std::runtime_error("Frozen catalogue has an id out of range");
+        }
+    };
+    for (StopId id = 0; id < header.stop_count; ++id) {
+        const StopRecord& record = GetStopRecord(id);
+        check_range(record.name, record.name_size, header.names_size);
+        check_range(record.buses_first, record.buses_count, stop_buses_count);
+    }
+    for (BusId id = 0; id < header.bus_count; ++id) {
+        const BusRecord& record = GetBusRecord(id);
+        check_range(record.name, record.name_size, header.names_size);
+        check_range(record.stops_first, record.stops_count, route_stops_count);
+        if (record.type != RouteType::Straight && record.type != RouteType::Round) {
+            throw std::runtime_error("Frozen catalogue has an unknown route type");
+        }
+    }
+    check_ids(header.stops_by_name, header.stop_count, header.stop_count);
+    check_ids(header.buses_by_name, header.bus_count, header.bus_count);
+    check_ids(header.stop_buses, stop_buses_count, header.bus_count);
+    check_ids(header.route_stops, route_stops_count, header.stop_count);
+}
+
+const FrozenCatalogue::Header& FrozenCatalogue::GetHeader() const {
+    return *reinterpret_cast<const Header*>(Data());
+}
+
+const FrozenCatalogue::StopRecord& FrozenCatalogue::GetStopRecord(StopId id) const {
+    return reinterpret_cast<const StopRecord*>(Data() + GetHeader().stops)[id];
+}
+
+const FrozenCatalogue::BusRecord& FrozenCatalogue::GetBusRecord(BusId id) const {
+    return reinterpret_cast<const BusRecord*>(Data() + GetHeader().buses)[id];
+}
+
+const uint32_t* FrozenCatalogue::GetIds(uint64_t offset) const {
+    return reinterpret_cast<const uint32_t*>(Data() + offset);
+}
+
+std::string_view FrozenCatalogue::GetName(uint32_t offset, uint32_t size) const {
+    return { Data() + GetHeader().names + offset, size };
+}
+
+} // namespace transport_catalogue
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "domain.h"
+#include "geo.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+using namespace domain;
+
+/*
+ * Неизменяемый снимок справочника в одном непрерывном блоке памяти.
+ * Внутри блока нет указателей — только смещения, поэтому его можно
+ * скопировать как есть. Имена интернированы в общий массив символов,
+ * списки маршрутов по остановкам отсортированы, для поиска по имени
+ * хранятся отсортированные индексы, статистика маршрутов посчитана заранее.
+ * Дополнительно в снимке может храниться готовое SVG-изображение карты.
+ * Блок записывается в файл как есть (Save), а Map отображает такой файл
+ * в память и обслуживает запросы прямо из отображённых страниц: несколько
+ * процессов используют одну физическую копию, разбора при загрузке нет
+ */
+class FrozenCatalogue {
+public:
+    FrozenCatalogue() = default;
+    explicit FrozenCatalogue(const TransportCatalogue& db, std::string_view rendered_map = {});
+
+    // Отображает в память файл, записанный Save. Бросает std::runtime_error,
+    // если файл недоступен или не является снимком справочника
+    static FrozenCatalogue Map(const std::string& path);
+    void Save(std::ostream& output) const;
+
+    std::optional<StopId> FindStop(std::string_view stop_name) const;
+    std::optional<BusId> FindRoute(std::string_view bus_name) const;
+
+    // Как и TransportCatalogue, бросает std::invalid_argument для неизвестного маршрута
+    std::optional<BusStat> GetRouteStatistics(const std::string_view& bus_name) const;
+    // Маршруты, проходящие через остановку, в порядке возрастания имён
+    std::vector<std::string_view> GetBusesByStop(const std::string_view& stop_name) const;
+
+    size_t GetStopCount() const;
+    size_t GetBusCount() const;
+    std::string_view GetStopName(StopId id) const;
+    geo::Coordinates GetStopCoordinates(StopId id) const;
+    std::string_view GetBusName(BusId id) const;
+    RouteType GetRouteType(BusId id) const;
+    StopIdRange GetRouteStopIds(BusId id) const;
+
+    bool HasRenderedMap() const;
+    std::string_view GetRenderedMap() const;
+
+    // Размер блока в байтах
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Header;
+    struct StopRecord;
+    struct BusRecord;
+
+    const char* Data() const;
+    size_t Size() const;
+    void Validate() const;
+    const Header& GetHeader() const;
+    const StopRecord& GetStopRecord(StopId id) const;
+    const BusRecord& GetBusRecord(BusId id) const;
+    const uint32_t* GetIds(uint64_t offset) const;
+    std::string_view GetName(uint32_t offset, uint32_t size) const;
+
+    // uint64_t гарантирует выравнивание записей внутри блока
+    std::vector<uint64_t> storage_;
+    // Отображённый файл; если задан, используется вместо storage_
+    std::shared_ptr<const char> mapped_;
+    size_t mapped_size_ = 0;
+};
+
+} // namespace transport_catalogue
@@ -2,16 +2,40 @@
 
 namespace geo {
 
+namespace {
+
+const double dr = M_PI / 180.;
+const int earth_rd = 6371000;
+
+} // namespace
+
 double ComputeDistance(Coordinates from, Coordinates to) {
     using namespace std;
     if (from == to) {
         return 0;
     }
-    static const double dr = M_PI / 180.;
-    static const int earth_rd = 6371000;
     return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
                 * earth_rd;
 }
 
-} // namespace geo
\ No newline at end of file
+SpherePoint ToSpherePoint(Coordinates point) {
+    return { point.lat, point.lng, std::sin(point.lat * dr), std::cos(point.lat * dr) };
+}
+
+void ComputeDistances(const SpherePoint* points, const uint32_t* path, size_t count, double* distances) {
+    using namespace std;
+    for (size_t i = 0; i + 1 < count; ++i) {
+        const SpherePoint& from = points[path[i]];
+        const SpherePoint& to = points[path[i + 1]];
+        if (from.lat == to.lat && from.lng == to.lng) {
+            distances[i] = 0;
+            continue;
+        }
+        distances[i] = acos(from.sin_lat * to.sin_lat
+                            + from.cos_lat * to.cos_lat * cos(abs(from.lng - to.lng) * dr))
+                            * earth_rd;
+    }
+}
+
+} // namespace geo
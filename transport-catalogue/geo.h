@@ -3,6 +3,9 @@
 #include <cmath> 
 #define _USE_MATH_DEFINES
 
+#include <cstddef>
+#include <cstdint>
+
 namespace geo {
 
 struct Coordinates {
@@ -18,4 +21,23 @@ struct Coordinates {
 
 double ComputeDistance(Coordinates from, Coordinates to);
 
+// Координаты точки вместе с заранее вычисленными синусом и косинусом широты
+struct SpherePoint {
+    double lat;
+    double lng;
+    double sin_lat;
+    double cos_lat;
+};
+
+SpherePoint ToSpherePoint(Coordinates point);
+
+/*
+ * Длины отрезков ломаной: distances[i] — расстояние от points[path[i]] до
+ * points[path[i + 1]] для i < count - 1. Тригонометрия широт берётся из
+ * SpherePoint, поэтому на отрезок остаются только cos разности долгот и acos.
+ * Вычисления и их порядок те же, что в ComputeDistance, так что результат
+ * совпадает с ним побайтно (допуск 0)
+ */
+void ComputeDistances(const SpherePoint* points, const uint32_t* path, size_t count, double* distances);
+
 } // namespace geo
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+
+namespace graph {
+
+using VertexId = size_t;
+using EdgeId = size_t;
+
+template <typename Weight>
+struct Edge {
+    VertexId from;
+    VertexId to;
+    Weight weight;
+};
+
+template <typename Weight>
+class DirectedWeightedGraph {
+private:
+    using IncidenceList = std::vector<EdgeId>;
+
+public:
+    DirectedWeightedGraph() = default;
+    explicit DirectedWeightedGraph(size_t vertex_count)
+        : incidence_lists_(vertex_count) {
+    }
+
+    EdgeId AddEdge(const Edge<Weight>& edge) {
+        edges_.push_back(edge);
+        const EdgeId id = edges_.size() - 1;
+        incidence_lists_.at(edge.from).push_back(id);
+        return id;
+    }
+
+    size_t GetVertexCount() const {
+        return incidence_lists_.size();
+    }
+
+    size_t GetEdgeCount() const {
+        return edges_.size();
+    }
+
+    const Edge<Weight>& GetEdge(EdgeId edge_id) const {
+        return edges_.at(edge_id);
+    }
+
+    const IncidenceList& GetIncidentEdges(VertexId vertex) const {
+        return incidence_lists_.at(vertex);
+    }
+
+private:
+    std::vector<Edge<Weight>> edges_;
+    std::vector<IncidenceList> incidence_lists_;
+};
+
+} // namespace graph
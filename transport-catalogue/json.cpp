@@ -1,4 +1,9 @@
 #include "json.h"
+#include "json_scan.h"
+
+#include <cctype>
+#include <charconv>
+#include <utility>
 
 namespace json {
 
@@ -6,231 +11,262 @@ namespace {
 
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+// Разбирает JSON из непрерывного буфера, двигая указатель по символам,
+// и сообщает о встреченных значениях получателю событий handler
+template <typename Handler>
+class Parser {
+public:
+    Parser(std::string_view text, Handler& handler)
+        : pos_(text.data())
+        , end_(text.data() + text.size())
+        , handler_(handler) {
+    }
 
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
+    void ParseNode() {
+        if (!SkipSpaces()) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        switch (*pos_) {
+        case '[':
+            ++pos_;
+            ParseArray();
+            break;
+        case '{':
+            ++pos_;
+            ParseDict();
+            break;
+        case '"':
+            ++pos_;
+            handler_.String(ParseString());
+            break;
+        case 't':
+            // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
+            // подсказкой компилятору и человеку, что здесь программист явно задумывал
+            // разрешить переход к инструкции следующей ветки case, а не случайно забыл
+            // написать break, return или throw.
+            // В данном случае, встретив t или f, переходим к попытке парсинга
+            // литералов true либо false
+            [[fallthrough]];
+        case 'f':
+            ParseBool();
+            break;
+        case 'n':
+            ParseNull();
+            break;
+        default:
+            ParseNumber();
+            break;
+        }
     }
-    return s;
-}
 
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+private:
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    static bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
 
-    for (char c; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
+    // Пропускает пробельные символы; возвращает false, если буфер закончился.
+    // Чаще всего пробелов нет вовсе, поэтому первый символ проверяется на месте
+    bool SkipSpaces() {
+        if (pos_ != end_ && IsSpace(*pos_)) {
+            pos_ = scan::SkipSpaces(pos_ + 1, end_);
         }
-        result.push_back(LoadNode(input));
+        return pos_ != end_;
     }
-    if (!input) {
-        throw ParsingError("Array parsing error"s);
+
+    std::string_view ParseLiteral() {
+        const char* first = pos_;
+        while (pos_ != end_ && std::isalpha(static_cast<unsigned char>(*pos_))) {
+            ++pos_;
+        }
+        return { first, static_cast<size_t>(pos_ - first) };
     }
-    return Node(std::move(result));
-}
 
-Node LoadDict(std::istream& input) {
-    Dict dict;
+    void ParseArray() {
+        handler_.StartArray();
+        while (SkipSpaces() && *pos_ != ']') {
+            if (*pos_ == ',') {
+                ++pos_;
+            }
+            ParseNode();
+        }
+        if (pos_ == end_) {
+            throw ParsingError("Array parsing error"s);
+        }
+        ++pos_;
+        handler_.EndArray();
+    }
 
-    for (char c; input >> c && c != '}';) {
-        if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
+    void ParseDict() {
+        handler_.StartDict();
+        while (SkipSpaces() && *pos_ != '}') {
+            const char c = *pos_++;
+            if (c == '"') {
+                const std::string_view key = ParseString();
+                if (SkipSpaces() && *pos_ == ':') {
+                    ++pos_;
+                    handler_.Key(key);
+                    ParseNode();
+                }
+                else {
+                    throw ParsingError(": is expected but '"s + (pos_ == end_ ? ""s : std::string(1, *pos_)) + "' has been found"s);
                 }
-                dict.emplace(std::move(key), LoadNode(input));
             }
-            else {
-                throw ParsingError(": is expected but '"s + c + "' has been found"s);
+            else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
             }
         }
-        else if (c != ',') {
-            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+        if (pos_ == end_) {
+            throw ParsingError("Dictionary parsing error"s);
         }
+        ++pos_;
+        handler_.EndDict();
     }
-    if (!input) {
-        throw ParsingError("Dictionary parsing error"s);
-    }
-    return Node(std::move(dict));
-}
 
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
-    while (true) {
-        if (it == end) {
-            throw ParsingError("String parsing error");
-        }
-        const char ch = *it;
-        if (ch == '"') {
-            ++it;
-            break;
-        }
-        else if (ch == '\\') {
-            ++it;
-            if (it == end) {
+    // Строка без escape-последовательностей возвращается как часть входного буфера,
+    // иначе собирается в buffer_ и действительна до следующего вызова
+    std::string_view ParseString() {
+        const char* first = pos_;
+        bool escaped = false;
+        while (true) {
+            // Пропускаем кусок без спецсимволов целиком
+            const char* chunk = pos_;
+            pos_ = scan::SkipStringBody(pos_, end_);
+            if (escaped) {
+                buffer_.append(chunk, pos_);
+            }
+            if (pos_ == end_) {
                 throw ParsingError("String parsing error");
             }
-            const char escaped_char = *(it);
+            const char ch = *pos_++;
+            if (ch == '"') {
+                break;
+            }
+            if (ch != '\\') {
+                throw ParsingError("Unexpected end of line"s);
+            }
+            if (!escaped) {
+                escaped = true;
+                buffer_.assign(first, pos_ - 1);
+            }
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error");
+            }
+            const char escaped_char = *pos_++;
             switch (escaped_char) {
             case 'n':
-                s.push_back('\n');
+                buffer_.push_back('\n');
                 break;
             case 't':
-                s.push_back('\t');
+                buffer_.push_back('\t');
                 break;
             case 'r':
-                s.push_back('\r');
+                buffer_.push_back('\r');
                 break;
             case '"':
-                s.push_back('"');
+                buffer_.push_back('"');
                 break;
             case '\\':
-                s.push_back('\\');
+                buffer_.push_back('\\');
                 break;
             default:
                 throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
             }
         }
-        else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
+        if (escaped) {
+            return buffer_;
+        }
+        return { first, static_cast<size_t>(pos_ - 1 - first) };
+    }
+
+    void ParseBool() {
+        const auto s = ParseLiteral();
+        if (s == "true"sv) {
+            handler_.Bool(true);
+        }
+        else if (s == "false"sv) {
+            handler_.Bool(false);
         }
         else {
-            s.push_back(ch);
+            throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
         }
-        ++it;
     }
 
-    return Node(std::move(s));
-}
-
-Node LoadBool(std::istream& input) {
-    const auto s = LoadLiteral(input);
-    if (s == "true"sv) {
-        return Node{ true };
-    }
-    else if (s == "false"sv) {
-        return Node{ false };
-    }
-    else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+    void ParseNull() {
+        if (auto literal = ParseLiteral(); literal == "null"sv) {
+            handler_.Null();
+        }
+        else {
+            throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
+        }
     }
-}
 
-Node LoadNull(std::istream& input) {
-    if (auto literal = LoadLiteral(input); literal == "null"sv) {
-        return Node{ nullptr };
-    }
-    else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
-    }
-}
+    void ParseNumber() {
+        const char* first = pos_;
 
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
+        // Считывает одну или более цифр
+        auto read_digits = [this] {
+            if (pos_ == end_ || !IsDigit(*pos_)) {
+                throw ParsingError("A digit is expected"s);
+            }
+            pos_ = scan::SkipDigits(pos_ + 1, end_);
+        };
 
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
+        if (pos_ != end_ && *pos_ == '-') {
+            ++pos_;
         }
-    };
-
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
+        // Парсим целую часть числа
+        if (pos_ != end_ && *pos_ == '0') {
+            ++pos_;
+            // После 0 в JSON не могут идти другие цифры
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        else {
+            read_digits();
         }
-    };
 
-    if (input.peek() == '-') {
-        read_char();
-    }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
-    }
-    else {
-        read_digits();
-    }
-
-    bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
-    }
+        bool is_int = true;
+        // Парсим дробную часть числа
+        if (pos_ != end_ && *pos_ == '.') {
+            ++pos_;
+            read_digits();
+            is_int = false;
+        }
 
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+        // Парсим экспоненциальную часть числа
+        if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+            ++pos_;
+            if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+                ++pos_;
+            }
+            read_digits();
+            is_int = false;
         }
-        read_digits();
-        is_int = false;
-    }
 
-    try {
         if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            }
-            catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
+            // Сначала пробуем преобразовать строку в int,
+            // при переполнении код ниже преобразует её в double
+            int value = 0;
+            if (const auto [ptr, ec] = std::from_chars(first, pos_, value); ec == std::errc{} && ptr == pos_) {
+                handler_.Int(value);
+                return;
             }
         }
-        return std::stod(parsed_num);
-    }
-    catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        double value = 0.0;
+        if (const auto [ptr, ec] = std::from_chars(first, pos_, value); ec == std::errc{} && ptr == pos_) {
+            handler_.Double(value);
+            return;
+        }
+        throw ParsingError("Failed to convert "s + std::string(first, pos_) + " to number"s);
     }
-}
 
-Node LoadNode(std::istream& input) {
-    char c;
-    if (!(input >> c)) {
-        throw ParsingError("Unexpected EOF"s);
-    }
-    switch (c) {
-    case '[':
-        return LoadArray(input);
-    case '{':
-        return LoadDict(input);
-    case '"':
-        return LoadString(input);
-    case 't':
-        // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-        // подсказкой компилятору и человеку, что здесь программист явно задумывал
-        // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-        // написать break, return или throw.
-        // В данном случае, встретив t или f, переходим к попытке парсинга
-        // литералов true либо false
-        [[fallthrough]];
-    case 'f':
-        input.putback(c);
-        return LoadBool(input);
-    case 'n':
-        input.putback(c);
-        return LoadNull(input);
-    default:
-        input.putback(c);
-        return LoadNumber(input);
-    }
-}
+    const char* pos_;
+    const char* end_;
+    Handler& handler_;
+    std::string buffer_;
+};
 
 struct PrintContext {
     std::ostream& out;
@@ -352,8 +388,90 @@ void PrintNode(const Node& node, const PrintContext& ctx) {
 
 }  // namespace
 
+// ---------- NodeHandler ------------------
+
+void NodeHandler::Null() {
+    Add(nullptr);
+}
+
+void NodeHandler::Bool(bool value) {
+    Add(value);
+}
+
+void NodeHandler::Int(int value) {
+    Add(value);
+}
+
+void NodeHandler::Double(double value) {
+    Add(value);
+}
+
+void NodeHandler::String(std::string_view value) {
+    Add(std::string(value));
+}
+
+void NodeHandler::Key(std::string_view key) {
+    key_ = key;
+    const auto& dict = std::get<Dict>(stack_.back()->GetValue());
+    if (dict.find(key_) != dict.end()) {
+        throw ParsingError("Duplicate key '"s + key_ + "' have been found");
+    }
+}
+
+void NodeHandler::StartArray() {
+    stack_.push_back(Add(Array{}));
+}
+
+void NodeHandler::EndArray() {
+    stack_.pop_back();
+}
+
+void NodeHandler::StartDict() {
+    stack_.push_back(Add(Dict{}));
+}
+
+void NodeHandler::EndDict() {
+    stack_.pop_back();
+}
+
+Node NodeHandler::ExtractRoot() {
+    stack_.clear();
+    return std::exchange(root_, nullptr);
+}
+
+Node* NodeHandler::Add(Node node) {
+    if (stack_.empty()) {
+        root_ = std::move(node);
+        return &root_;
+    }
+    // Пока вложенный контейнер открыт, в родителя ничего не добавляется,
+    // поэтому указатели в stack_ остаются действительными
+    auto& parent = stack_.back()->GetValue();
+    if (auto* array = std::get_if<Array>(&parent)) {
+        return &array->emplace_back(std::move(node));
+    }
+    auto& dict = std::get<Dict>(parent);
+    return &dict.emplace(std::move(key_), std::move(node)).first->second;
+}
+
+void Parse(std::istream& input, Handler& handler) {
+    const std::string text{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    Parse(text, handler);
+}
+
+void Parse(std::string_view text, Handler& handler) {
+    Parser<Handler>(text, handler).ParseNode();
+}
+
 Document Load(std::istream& input) {
-    return Document{ LoadNode(input) };
+    const std::string text{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    return Load(text);
+}
+
+Document Load(std::string_view text) {
+    NodeHandler handler;
+    Parser<NodeHandler>(text, handler).ParseNode();
+    return Document{ handler.ExtractRoot() };
 }
 
 void Print(const Document& doc, std::ostream& output) {
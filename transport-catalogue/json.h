@@ -4,6 +4,7 @@
 #include <iterator>
 #include <map>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -140,7 +141,59 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+/*
+ * Получатель событий потокового (SAX) разбора: значения сообщаются по мере чтения,
+ * без построения дерева. Строки и ключи действительны только до возврата из вызова.
+ * Ключ словаря сообщается вызовом Key перед событиями своего значения
+ */
+class Handler {
+public:
+    virtual ~Handler() = default;
+
+    virtual void Null() = 0;
+    virtual void Bool(bool value) = 0;
+    virtual void Int(int value) = 0;
+    virtual void Double(double value) = 0;
+    virtual void String(std::string_view value) = 0;
+    virtual void Key(std::string_view key) = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void StartDict() = 0;
+    virtual void EndDict() = 0;
+};
+
+// Собирает из событий разбора дерево Node; на нём построена функция Load
+class NodeHandler final : public Handler {
+public:
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void Key(std::string_view key) override;
+    void StartArray() override;
+    void EndArray() override;
+    void StartDict() override;
+    void EndDict() override;
+
+    // Возвращает собранное значение и готовит обработчик к следующему
+    Node ExtractRoot();
+
+private:
+    Node* Add(Node node);
+
+    Node root_ = nullptr;
+    std::vector<Node*> stack_;
+    std::string key_;
+};
+
+// Разбирает первое значение текста, сообщая о нём handler
+void Parse(std::istream& input, Handler& handler);
+void Parse(std::string_view text, Handler& handler);
+
+// Читает поток целиком и разбирает его как Load(std::string_view)
 Document Load(std::istream& input);
+Document Load(std::string_view text);
 
 void Print(const Document& doc, std::ostream& output);
 
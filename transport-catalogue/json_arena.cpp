@@ -0,0 +1,274 @@
+#include "json_arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace json {
+
+using namespace std::literals;
+
+// ---------- ArenaNode ------------------
+
+bool ArenaNode::IsNull() const {
+    return type_ == Type::NULL_VALUE;
+}
+
+bool ArenaNode::IsBool() const {
+    return type_ == Type::BOOL;
+}
+
+bool ArenaNode::IsInt() const {
+    return type_ == Type::INT;
+}
+
+bool ArenaNode::IsPureDouble() const {
+    return type_ == Type::DOUBLE;
+}
+
+bool ArenaNode::IsDouble() const {
+    return IsInt() || IsPureDouble();
+}
+
+bool ArenaNode::IsString() const {
+    return type_ == Type::STRING;
+}
+
+bool ArenaNode::IsArray() const {
+    return type_ == Type::ARRAY;
+}
+
+bool ArenaNode::IsDict() const {
+    return type_ == Type::DICT;
+}
+
+bool ArenaNode::AsBool() const {
+    if (!IsBool()) {
+        throw std::logic_error("Not a bool"s);
+    }
+    return bool_;
+}
+
+int ArenaNode::AsInt() const {
+    if (!IsInt()) {
+        throw std::logic_error("Not an int"s);
+    }
+    return int_;
+}
+
+double ArenaNode::AsDouble() const {
+    if (!IsDouble()) {
+        throw std::logic_error("Not a double"s);
+    }
+    return IsPureDouble() ? double_ : int_;
+}
+
+std::string_view ArenaNode::AsString() const {
+    if (!IsString()) {
+        throw std::logic_error("Not a string"s);
+    }
+    return { chars_, size_ };
+}
+
+ArenaArray ArenaNode::AsArray() const {
+    if (!IsArray()) {
+        throw std::logic_error("Not an array"s);
+    }
+    return { items_, size_ };
+}
+
+ArenaDict ArenaNode::AsDict() const {
+    if (!IsDict()) {
+        throw std::logic_error("Not a dict"s);
+    }
+    return { members_, size_ };
+}
+
+// ---------- ArenaArray ------------------
+
+const ArenaNode& ArenaArray::at(size_t index) const {
+    if (index >= size_) {
+        throw std::out_of_range("Array index "s + std::to_string(index) + " is out of range"s);
+    }
+    return items_[index];
+}
+
+// ---------- ArenaDict ------------------
+
+const ArenaDict::Member* ArenaDict::find(std::string_view key) const {
+    const Member* it = std::lower_bound(begin(), end(), key, [](const Member& member, std::string_view key) {
+        return member.first < key;
+    });
+    return it != end() && it->first == key ? it : end();
+}
+
+size_t ArenaDict::count(std::string_view key) const {
+    return find(key) != end() ? 1 : 0;
+}
+
+const ArenaNode& ArenaDict::at(std::string_view key) const {
+    const Member* it = find(key);
+    if (it == end()) {
+        throw std::out_of_range("Key '"s + std::string(key) + "' is not found"s);
+    }
+    return it->second;
+}
+
+// ---------- ArenaDocument ------------------
+
+ArenaDocument::ArenaDocument(std::string text)
+    : text_(std::make_unique<const std::string>(std::move(text)))
+    , arena_(std::make_unique<std::pmr::monotonic_buffer_resource>()) {
+}
+
+std::string_view ArenaDocument::GetText() const {
+    return *text_;
+}
+
+const ArenaNode& ArenaDocument::GetRoot() const {
+    return root_;
+}
+
+size_t ArenaDocument::GetArenaSize() const {
+    return arena_size_;
+}
+
+void* ArenaDocument::Allocate(size_t bytes, size_t alignment) {
+    arena_size_ += bytes;
+    return arena_->allocate(bytes, alignment);
+}
+
+// ---------- ArenaBuilder ------------------
+
+ArenaBuilder::ArenaBuilder(ArenaDocument& document)
+    : document_(document) {
+}
+
+void ArenaBuilder::Null() {
+    Add(key_, ArenaNode{});
+}
+
+void ArenaBuilder::Bool(bool value) {
+    ArenaNode node;
+    node.type_ = ArenaNode::Type::BOOL;
+    node.bool_ = value;
+    Add(key_, node);
+}
+
+void ArenaBuilder::Int(int value) {
+    ArenaNode node;
+    node.type_ = ArenaNode::Type::INT;
+    node.int_ = value;
+    Add(key_, node);
+}
+
+void ArenaBuilder::Double(double value) {
+    ArenaNode node;
+    node.type_ = ArenaNode::Type::DOUBLE;
+    node.double_ = value;
+    Add(key_, node);
+}
+
+void ArenaBuilder::String(std::string_view value) {
+    const std::string_view stored = Store(value);
+    ArenaNode node;
+    node.type_ = ArenaNode::Type::STRING;
+    node.size_ = static_cast<uint32_t>(stored.size());
+    node.chars_ = stored.data();
+    Add(key_, node);
+}
+
+void ArenaBuilder::Key(std::string_view key) {
+    key_ = Store(key);
+}
+
+void ArenaBuilder::StartArray() {
+    frames_.push_back({ key_, pending_.size() });
+}
+
+void ArenaBuilder::EndArray() {
+    const Frame frame = frames_.back();
+    frames_.pop_back();
+    const size_t size = pending_.size() - frame.first;
+
+    auto* items = static_cast<ArenaNode*>(document_.Allocate(size * sizeof(ArenaNode), alignof(ArenaNode)));
+    std::transform(pending_.begin() + frame.first, pending_.end(), items, [](const ArenaDict::Member& member) {
+        return member.second;
+    });
+    pending_.resize(frame.first);
+
+    ArenaNode node;
+    node.type_ = ArenaNode::Type::ARRAY;
+    node.size_ = static_cast<uint32_t>(size);
+    node.items_ = items;
+    Add(frame.key, node);
+}
+
+void ArenaBuilder::StartDict() {
+    frames_.push_back({ key_, pending_.size() });
+}
+
+void ArenaBuilder::EndDict() {
+    const Frame frame = frames_.back();
+    frames_.pop_back();
+    const auto first = pending_.begin() + frame.first;
+    const size_t size = pending_.size() - frame.first;
+
+    std::sort(first, pending_.end(), [](const ArenaDict::Member& lhs, const ArenaDict::Member& rhs) {
+        return lhs.first < rhs.first;
+    });
+    const auto duplicate = std::adjacent_find(first, pending_.end(), [](const ArenaDict::Member& lhs, const ArenaDict::Member& rhs) {
+        return lhs.first == rhs.first;
+    });
+    if (duplicate != pending_.end()) {
+        throw ParsingError("Duplicate key '"s + std::string(duplicate->first) + "' have been found");
+    }
+
+    auto* members = static_cast<ArenaDict::Member*>(document_.Allocate(size * sizeof(ArenaDict::Member), alignof(ArenaDict::Member)));
+    std::uninitialized_copy(first, pending_.end(), members);
+    pending_.resize(frame.first);
+
+    ArenaNode node;
+    node.type_ = ArenaNode::Type::DICT;
+    node.size_ = static_cast<uint32_t>(size);
+    node.members_ = members;
+    Add(frame.key, node);
+}
+
+void ArenaBuilder::Finish() {
+    document_.root_ = root_;
+}
+
+std::string_view ArenaBuilder::Store(std::string_view text) {
+    // Строка без escape-последовательностей указывает в текст документа;
+    // раскодированную разборщик отдаёт во временном буфере, её копируем в арену
+    const std::string_view source = document_.GetText();
+    if (text.data() >= source.data() && text.data() + text.size() <= source.data() + source.size()) {
+        return text;
+    }
+    auto* chars = static_cast<char*>(document_.Allocate(text.size(), 1));
+    std::memcpy(chars, text.data(), text.size());
+    return { chars, text.size() };
+}
+
+void ArenaBuilder::Add(std::string_view key, ArenaNode node) {
+    if (frames_.empty()) {
+        root_ = node;
+        return;
+    }
+    pending_.emplace_back(key, node);
+}
+
+ArenaDocument LoadArena(std::istream& input) {
+    return LoadArena(std::string{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() });
+}
+
+ArenaDocument LoadArena(std::string text) {
+    ArenaDocument document(std::move(text));
+    ArenaBuilder builder(document);
+    Parse(document.GetText(), builder);
+    builder.Finish();
+    return document;
+}
+
+} // namespace json
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+class ArenaNode;
+class ArenaArray;
+class ArenaDict;
+class ArenaBuilder;
+
+/*
+ * Узел компактного неизменяемого DOM. Узел занимает 16 байт: тип, длина и
+ * значение либо указатель на элементы. Элементы массивов и словарей лежат
+ * в арене документа подряд, строки и ключи ссылаются на текст документа.
+ * Методы Is.../As... ведут себя как у json::Node, но AsString возвращает string_view
+ */
+class ArenaNode {
+public:
+    ArenaNode() = default;
+
+    bool IsNull() const;
+    bool IsBool() const;
+    bool IsInt() const;
+    bool IsPureDouble() const;
+    bool IsDouble() const;
+    bool IsString() const;
+    bool IsArray() const;
+    bool IsDict() const;
+
+    bool AsBool() const;
+    int AsInt() const;
+    double AsDouble() const;
+    std::string_view AsString() const;
+    ArenaArray AsArray() const;
+    ArenaDict AsDict() const;
+
+private:
+    friend class ArenaBuilder;
+
+    enum class Type : uint8_t {
+        NULL_VALUE,
+        BOOL,
+        INT,
+        DOUBLE,
+        STRING,
+        ARRAY,
+        DICT,
+    };
+
+    Type type_ = Type::NULL_VALUE;
+    // Длина строки или количество элементов
+    uint32_t size_ = 0;
+    union {
+        bool bool_;
+        int int_;
+        double double_;
+        const char* chars_ = nullptr;
+        const ArenaNode* items_;
+        const std::pair<std::string_view, ArenaNode>* members_;
+    };
+};
+
+// Массив: непрерывный диапазон узлов
+class ArenaArray {
+public:
+    ArenaArray(const ArenaNode* items, size_t size)
+        : items_(items)
+        , size_(size) {
+    }
+
+    const ArenaNode* begin() const {
+        return items_;
+    }
+    const ArenaNode* end() const {
+        return items_ + size_;
+    }
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+    const ArenaNode& operator[](size_t index) const {
+        return items_[index];
+    }
+    const ArenaNode& at(size_t index) const;
+
+private:
+    const ArenaNode* items_;
+    size_t size_;
+};
+
+// Словарь: пары (ключ, значение), упорядоченные по ключу; поиск двоичный
+class ArenaDict {
+public:
+    using Member = std::pair<std::string_view, ArenaNode>;
+
+    ArenaDict(const Member* members, size_t size)
+        : members_(members)
+        , size_(size) {
+    }
+
+    const Member* begin() const {
+        return members_;
+    }
+    const Member* end() const {
+        return members_ + size_;
+    }
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    const Member* find(std::string_view key) const;
+    size_t count(std::string_view key) const;
+    const ArenaNode& at(std::string_view key) const;
+
+private:
+    const Member* members_;
+    size_t size_;
+};
+
+/*
+ * Документ владеет текстом и ареной (std::pmr::monotonic_buffer_resource),
+ * в которой лежат массивы и словари. Строки, лежащие в тексте документа без
+ * escape-последовательностей, не копируются; в арену копируются раскодированные
+ * разборщиком строки и строки из любого другого буфера. После построения
+ * документ только читается, поэтому его можно обходить из нескольких потоков
+ */
+class ArenaDocument {
+public:
+    using Builder = ArenaBuilder;
+
+    explicit ArenaDocument(std::string text);
+
+    std::string_view GetText() const;
+    const ArenaNode& GetRoot() const;
+    // Байты, выделенные в арене под узлы и раскодированные строки
+    size_t GetArenaSize() const;
+
+private:
+    friend class ArenaBuilder;
+
+    void* Allocate(size_t bytes, size_t alignment);
+
+    // Текст и арена лежат в отдельных блоках, чтобы ссылки на них переживали перемещение документа
+    std::unique_ptr<const std::string> text_;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    size_t arena_size_ = 0;
+    ArenaNode root_;
+};
+
+/*
+ * Собирает узлы документа из событий разбора. Дочерние узлы открытых контейнеров
+ * копятся в общем стеке и переносятся в арену одним блоком, когда контейнер закрывается.
+ * Дубликат ключа обнаруживается при закрытии словаря
+ */
+class ArenaBuilder final : public Handler {
+public:
+    explicit ArenaBuilder(ArenaDocument& document);
+
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void Key(std::string_view key) override;
+    void StartArray() override;
+    void EndArray() override;
+    void StartDict() override;
+    void EndDict() override;
+
+    // Делает собранное значение корнем документа
+    void Finish();
+
+private:
+    struct Frame {
+        // Ключ, под которым контейнер попадёт в родительский словарь
+        std::string_view key;
+        // Начало дочерних узлов в pending_
+        size_t first;
+    };
+
+    std::string_view Store(std::string_view text);
+    void Add(std::string_view key, ArenaNode node);
+
+    ArenaDocument& document_;
+    std::vector<ArenaDict::Member> pending_;
+    std::vector<Frame> frames_;
+    std::string_view key_;
+    ArenaNode root_;
+};
+
+// Читает поток целиком и разбирает его в компактный документ
+ArenaDocument LoadArena(std::istream& input);
+ArenaDocument LoadArena(std::string text);
+
+} // namespace json
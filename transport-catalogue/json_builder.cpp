@@ -1,31 +1,31 @@
 #include "json_builder.h"
 
+#include <utility>
+
 namespace json {
     
     
 // --------------- Builder ---------------
     
-DictKeyContext Builder::Key(const std::string& key) {
-    if (nodes_stack_.empty()) {
+DictKeyContext Builder::Key(std::string key) {
+    if (nodes_stack_.empty() || !nodes_stack_.back()->IsDict() || has_key_) {
         throw std::logic_error("Wrong map key: " + key);
     }
 
-    auto key_ptr = std::make_unique<Node>(key);
-    
-    if (nodes_stack_.back()->IsDict()) {
-        nodes_stack_.emplace_back(std::move(key_ptr));
-    }
- 
+    key_ = std::move(key);
+    has_key_ = true;
     return DictKeyContext(*this);
 }
 
-Builder& Builder::Value(const Node::Value& value) {
-    AddNode(GetNode(value));
+Builder& Builder::Value(Node::Value value) {
+    Node node;
+    node.GetValue() = std::move(value);
+    AddNode(std::move(node));
     return *this;
 }
 
 DictItemContext Builder::StartDict() {
-    nodes_stack_.emplace_back(std::move(std::make_unique<Node>(Dict())));
+    nodes_stack_.push_back(AddNode(Dict()));
     return DictItemContext(*this);
 }
 
@@ -34,19 +34,16 @@ Builder& Builder::EndDict() {
         throw std::logic_error("Unable to close as without opening");
     }
     
-    if (!nodes_stack_.back()->IsDict()) {
+    if (!nodes_stack_.back()->IsDict() || has_key_) {
         throw std::logic_error("Prev node is not a Dict");
     }
  
-    Node node = *nodes_stack_.back();
     nodes_stack_.pop_back();
-    AddNode(node);
- 
     return *this;
 }
 
 ArrayItemContext Builder::StartArray() {
-    nodes_stack_.emplace_back(std::move(std::make_unique<Node>(Array())));
+    nodes_stack_.push_back(AddNode(Array()));
     return ArrayItemContext(*this);
 }
 
@@ -59,78 +56,37 @@ Builder& Builder::EndArray() {
         throw std::logic_error("Prev node is not an Array");
     }
     
-    Node node = *nodes_stack_.back();
     nodes_stack_.pop_back();
-    AddNode(node);
     return *this;
 }
 
 Node Builder::Build() {
-    if (root_.IsNull() || nodes_stack_.size() > 1) {
+    if (root_.IsNull() || !nodes_stack_.empty()) {
         throw std::logic_error("Wrong Build()");
     }
-    return root_;
+    return std::exchange(root_, nullptr);
 }
     
-void Builder::AddNode(const Node& node) {
+Node* Builder::AddNode(Node node) {
     if (nodes_stack_.empty()) { 
         if (!root_.IsNull()) {
             throw std::logic_error("Unable to create node");
         }
-        root_ = node;
-        return;
-    }
-    
-    if (nodes_stack_.back()->IsArray()) {
-        auto array = nodes_stack_.back()->AsArray();
-        array.emplace_back(node);
-        nodes_stack_.pop_back();
-        auto arr_ptr = std::make_unique<Node>(array);
-        nodes_stack_.emplace_back(std::move(arr_ptr));
-        return;
+        root_ = std::move(node);
+        return &root_;
     }
     
-    if (nodes_stack_.back()->IsString()) {
-        auto str = nodes_stack_.back()->AsString();
-        nodes_stack_.pop_back();
-        
-        if (nodes_stack_.back()->IsDict()) {
-            auto dict = nodes_stack_.back()->AsDict();
-            dict.emplace(std::move(str), node);
-            nodes_stack_.pop_back();
-            auto dict_ptr = std::make_unique<Node>(dict);
-            nodes_stack_.emplace_back(std::move(dict_ptr));
-        }
-        
-        return;
+    auto& parent = nodes_stack_.back()->GetValue();
+    if (auto* array = std::get_if<Array>(&parent)) {
+        return &array->emplace_back(std::move(node));
     }
     
-    throw std::logic_error("Value() called in unknow container");
-}
-
-Node Builder::GetNode(const Node::Value& value) {
-    if (std::holds_alternative<int>(value)) {
-        return Node(std::get<int>(value));
-    }
-    if (std::holds_alternative<double>(value)) {
-        return Node(std::get<double>(value));
-    }
-    if (std::holds_alternative<std::string>(value)) {
-        return Node(std::get<std::string>(value));
-    }
-    if (std::holds_alternative<std::nullptr_t>(value)) {
-        return Node(std::get<std::nullptr_t>(value));
-    }
-    if (std::holds_alternative<bool>(value)) {
-        return Node(std::get<bool>(value));
-    }
-    if (std::holds_alternative<Dict>(value)) {
-        return Node(std::get<Dict>(value));
-    }
-    if (std::holds_alternative<Array>(value)) {
-        return Node(std::get<Array>(value));
+    if (!has_key_) {
+        throw std::logic_error("Value() called in unknow container");
     }
-    return {};
+    has_key_ = false;
+    auto& dict = std::get<Dict>(parent);
+    return &dict.emplace(std::move(key_), std::move(node)).first->second;
 }
     
 // --------------- BaseContext ---------------
@@ -139,12 +95,12 @@ BaseContext::BaseContext(Builder& builder)
     : builder_(builder) {
 }
  
-DictKeyContext BaseContext::Key(const std::string& key) {
-    return builder_.Key(key);
+DictKeyContext BaseContext::Key(std::string key) {
+    return builder_.Key(std::move(key));
 }
     
-Builder& BaseContext::Value(const Node::Value& value) {
-    return builder_.Value(value);
+Builder& BaseContext::Value(Node::Value value) {
+    return builder_.Value(std::move(value));
 }
     
 ArrayItemContext BaseContext::StartArray() {
@@ -2,8 +2,8 @@
 
 #include "json.h"
 
-#include <memory>
-#include <optional>
+#include <string>
+#include <vector>
 
 namespace json {
     
@@ -11,10 +11,24 @@ class DictItemContext;
 class DictKeyContext;
 class ArrayItemContext;
 
+/*
+ * Строит Node по цепочке вызовов. Значения и законченные поддеревья
+ * перемещаются в родительский контейнер без копирования: стек хранит указатели
+ * на открытые контейнеры внутри строящегося дерева. Build отдаёт результат
+ * и готовит строитель к следующему значению, сохраняя ёмкость стека.
+ * Строитель не копируется и не перемещается: стек указывает на его корень,
+ * а контексты цепочки вызовов держат ссылку на него самого
+ */
 class Builder {
-public:    
-    DictKeyContext Key(const std::string& key);
-    Builder& Value(const Node::Value& value);
+public:
+    Builder() = default;
+    Builder(const Builder&) = delete;
+    Builder& operator=(const Builder&) = delete;
+    Builder(Builder&&) = delete;
+    Builder& operator=(Builder&&) = delete;
+
+    DictKeyContext Key(std::string key);
+    Builder& Value(Node::Value value);
     
     DictItemContext StartDict();
     Builder& EndDict();
@@ -23,20 +37,24 @@ public:
     Builder& EndArray();
     
     Node Build();
-    void AddNode(const Node& node);
-    Node GetNode(const Node::Value& value);
+    // Добавляет готовый узел в открытый контейнер или делает его корнем
+    Node* AddNode(Node node);
 
 private:
     Node root_{nullptr};
-    std::vector<std::unique_ptr<Node>> nodes_stack_;
+    // Открытые контейнеры; указатели остаются действительными, пока в родителя
+    // ничего не добавляется, то есть пока вложенный контейнер открыт
+    std::vector<Node*> nodes_stack_;
+    std::string key_;
+    bool has_key_ = false;
 };
     
 class BaseContext {
 public:
     BaseContext(Builder& builder);
  
-    DictKeyContext Key(const std::string& key);
-    Builder& Value(const Node::Value& value);
+    DictKeyContext Key(std::string key);
+    Builder& Value(Node::Value value);
     
     ArrayItemContext StartArray();
     Builder& EndArray();
@@ -52,7 +70,7 @@ class DictItemContext : public BaseContext {
 public:
     DictItemContext(Builder& builder);
     
-    Builder& Value(const Node::Value& value) = delete;
+    Builder& Value(Node::Value value) = delete;
     ArrayItemContext StartArray() = delete;
     Builder& EndArray() = delete;
     DictItemContext StartDict() = delete;
@@ -62,7 +80,7 @@ class DictKeyContext : public BaseContext {
 public:
     DictKeyContext(Builder& builder);
     
-    DictKeyContext Key(const std::string& key) = delete;
+    DictKeyContext Key(std::string key) = delete;
     Builder& EndArray() = delete;
     Builder& EndDict() = delete;
 };
@@ -71,7 +89,7 @@ class ArrayItemContext : public BaseContext {
 public:
     ArrayItemContext(Builder& builder);
     
-    DictKeyContext Key(const std::string& key) = delete;
+    DictKeyContext Key(std::string key) = delete;
     Builder& EndDict() = delete;
 };
 
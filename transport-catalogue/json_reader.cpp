@@ -1,20 +1,393 @@
 #include "json_reader.h"
 
-const json::Node& JsonReader::GetBaseRequests() const {
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+namespace {
+
+using namespace std::literals;
+
+// Отступ ответа внутри выводимого массива ответов
+const int RESPONSE_INDENT = 4;
+// Наибольшее число знаков после запятой у координат компактной карты
+const int MAX_COMPACT_PRECISION = 10;
+
+/*
+ * Потоковый загрузчик: записи base_requests применяются к справочнику по мере
+ * разбора, остальные события передаются builder и собирают документ без base_requests.
+ * Остановки добавляются сразу, расстояния — как только известны обе остановки.
+ * Маршруты добавляются в конце base_requests в исходном порядке, чтобы BusId
+ * совпадали с FillCatalogue; откладываются только имена ещё не встреченных остановок
+ */
+class CatalogueLoader final : public json::Handler {
+public:
+    CatalogueLoader(TransportCatalogue& db, json::Handler& builder)
+        : db_(db)
+        , builder_(builder) {
+    }
+
+    void Null() override {
+        if (OnValue()) {
+            builder_.Null();
+        }
+    }
+
+    void Bool(bool value) override {
+        if (OnValue()) {
+            builder_.Bool(value);
+        }
+        else if (depth_ == RECORD_DEPTH && field_ == "is_roundtrip"sv) {
+            record_.is_roundtrip = value;
+        }
+    }
+
+    void Int(int value) override {
+        if (OnValue()) {
+            builder_.Int(value);
+        }
+        else if (depth_ == RECORD_DEPTH + 1 && field_ == "road_distances"sv) {
+            record_.distances.back().second = value;
+        }
+        else {
+            SetCoordinate(value);
+        }
+    }
+
+    void Double(double value) override {
+        if (OnValue()) {
+            builder_.Double(value);
+        }
+        else if (depth_ == RECORD_DEPTH + 1 && field_ == "road_distances"sv) {
+            throw std::logic_error("Not an int"s);
+        }
+        else {
+            SetCoordinate(value);
+        }
+    }
+
+    void String(std::string_view value) override {
+        if (OnValue()) {
+            builder_.String(value);
+        }
+        else if (depth_ == RECORD_DEPTH && field_ == "type"sv) {
+            record_.type = value;
+        }
+        else if (depth_ == RECORD_DEPTH && field_ == "name"sv) {
+            record_.name = value;
+        }
+        else if (depth_ == RECORD_DEPTH + 1 && field_ == "stops"sv) {
+            record_.stops.emplace_back(value);
+        }
+    }
+
+    void Key(std::string_view key) override {
+        if (depth_ == 1) {
+            in_base_requests_ = key == "base_requests"sv;
+            if (!in_base_requests_) {
+                builder_.Key(key);
+            }
+            else if (base_requests_seen_) {
+                throw json::ParsingError("Duplicate key 'base_requests' have been found"s);
+            }
+            base_requests_seen_ = base_requests_seen_ || in_base_requests_;
+        }
+        else if (!in_base_requests_) {
+            builder_.Key(key);
+        }
+        else if (depth_ == RECORD_DEPTH) {
+            field_ = key;
+        }
+        else if (depth_ == RECORD_DEPTH + 1 && field_ == "road_distances"sv) {
+            record_.distances.emplace_back(std::string(key), 0);
+        }
+    }
+
+    void StartArray() override {
+        if (OnValue()) {
+            builder_.StartArray();
+        }
+        ++depth_;
+    }
+
+    void EndArray() override {
+        --depth_;
+        if (!in_base_requests_) {
+            builder_.EndArray();
+        }
+        else if (depth_ == 1) {
+            FinishBaseRequests();
+        }
+    }
+
+    void StartDict() override {
+        if (depth_ == 0 || OnValue()) {
+            builder_.StartDict();
+        }
+        else if (depth_ == RECORD_DEPTH - 1) {
+            record_.Clear();
+        }
+        ++depth_;
+    }
+
+    void EndDict() override {
+        --depth_;
+        if (depth_ == 0 || !in_base_requests_) {
+            builder_.EndDict();
+        }
+        else if (depth_ == RECORD_DEPTH - 1) {
+            ApplyRecord();
+        }
+    }
+
+private:
+    // Глубина полей записи: корневой словарь, массив base_requests, словарь записи
+    static constexpr int RECORD_DEPTH = 3;
+
+    struct Record {
+        std::string type;
+        std::string name;
+        std::optional<double> latitude;
+        std::optional<double> longitude;
+        std::vector<std::pair<std::string, int>> distances;
+        std::vector<std::string> stops;
+        std::optional<bool> is_roundtrip;
+
+        void Clear() {
+            type.clear();
+            name.clear();
+            latitude.reset();
+            longitude.reset();
+            distances.clear();
+            stops.clear();
+            is_roundtrip.reset();
+        }
+    };
+
+    struct PendingDistance {
+        StopPtr from;
+        std::string to;
+        int distance;
+    };
+
+    struct PendingRoute {
+        std::string name;
+        std::vector<StopPtr> stops;
+        bool is_roundtrip;
+        // Позиции в stops, чьи остановки ещё не встречались, и их имена
+        std::vector<std::pair<size_t, std::string>> unresolved;
+    };
+
+    // Значение вне base_requests передаётся в документ; возвращает false для base_requests
+    bool OnValue() {
+        if (depth_ == 0) {
+            throw std::logic_error("Not a dict"s);
+        }
+        return !in_base_requests_;
+    }
+
+    void SetCoordinate(double value) {
+        if (depth_ != RECORD_DEPTH) {
+            return;
+        }
+        if (field_ == "latitude"sv) {
+            record_.latitude = value;
+        }
+        else if (field_ == "longitude"sv) {
+            record_.longitude = value;
+        }
+    }
+
+    void ApplyRecord() {
+        if (record_.type == "Stop"sv) {
+            if (!record_.latitude || !record_.longitude) {
+                throw std::logic_error("Stop "s + record_.name + " has no coordinates"s);
+            }
+            db_.AddStop(record_.name, { *record_.latitude, *record_.longitude });
+            const StopPtr from = db_.GetStop(record_.name);
+            for (auto& [to_name, distance] : record_.distances) {
+                if (const StopPtr to = db_.GetStop(to_name)) {
+                    db_.SetStopDistance(from, to, distance);
+                }
+                else {
+                    pending_distances_.push_back({ from, std::move(to_name), distance });
+                }
+            }
+        }
+        else if (record_.type == "Bus"sv) {
+            if (!record_.is_roundtrip) {
+                throw std::logic_error("Bus "s + record_.name + " has no is_roundtrip"s);
+            }
+            PendingRoute route{ std::move(record_.name), {}, *record_.is_roundtrip, {} };
+            route.stops.reserve(record_.stops.size());
+            for (auto& stop_name : record_.stops) {
+                const StopPtr stop = db_.GetStop(stop_name);
+                if (!stop) {
+                    route.unresolved.emplace_back(route.stops.size(), std::move(stop_name));
+                }
+                route.stops.push_back(stop);
+            }
+            routes_.push_back(std::move(route));
+        }
+    }
+
+    StopPtr ResolveStop(const std::string& name) const {
+        const StopPtr stop = db_.GetStop(name);
+        if (!stop) {
+            throw std::logic_error("Unknown stop "s + name);
+        }
+        return stop;
+    }
+
+    void FinishBaseRequests() {
+        for (const auto& [from, to, distance] : pending_distances_) {
+            db_.SetStopDistance(from, ResolveStop(to), distance);
+        }
+        pending_distances_ = {};
+
+        std::vector<std::tuple<std::string_view, std::vector<StopPtr>, bool>> routes;
+        routes.reserve(routes_.size());
+        for (auto& route : routes_) {
+            for (const auto& [index, name] : route.unresolved) {
+                route.stops[index] = ResolveStop(name);
+            }
+            routes.emplace_back(route.name, std::move(route.stops), route.is_roundtrip);
+        }
+        db_.AddRoutes(routes);
+        routes_ = {};
+        in_base_requests_ = false;
+    }
+
+    TransportCatalogue& db_;
+    json::Handler& builder_;
+    int depth_ = 0;
+
+    bool in_base_requests_ = false;
+    bool base_requests_seen_ = false;
+
+    std::string field_;
+    Record record_;
+    std::vector<PendingDistance> pending_distances_;
+    std::vector<PendingRoute> routes_;
+};
+
+// Ответ на запрос, который не удалось выполнить; без id, если его не удалось прочитать
+void WriteError(json::Writer& writer, std::string_view message, std::optional<int> id) {
+    writer.StartDict();
+    writer.Key("error_message"); writer.String(message);
+    if (id) {
+        writer.Key("request_id"); writer.Int(*id);
+    }
+    writer.EndDict();
+}
+
+template <typename Node>
+std::optional<int> ReadRequestId(const Node& request) {
+    try {
+        return request.AsDict().at("id").AsInt();
+    }
+    catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+// Область запроса Map: "bbox" с полями min_lat, min_lon, max_lat, max_lon
+// или тайл "tile" с полями z, x, y. Без них запрашивается вся карта
+template <typename Dict>
+std::optional<renderer::Viewport> ReadViewport(const Dict& request_map) {
+    if (const auto it = request_map.find("bbox"); it != request_map.end()) {
+        const auto bbox = it->second.AsDict();
+        const renderer::Viewport viewport{
+            { bbox.at("min_lat").AsDouble(), bbox.at("min_lon").AsDouble() },
+            { bbox.at("max_lat").AsDouble(), bbox.at("max_lon").AsDouble() }
+        };
+        if (viewport.min.lat > viewport.max.lat || viewport.min.lng > viewport.max.lng) {
+            throw std::invalid_argument("Map bbox minimum exceeds its maximum");
+        }
+        return viewport;
+    }
+    if (const auto it = request_map.find("tile"); it != request_map.end()) {
+        const auto tile = it->second.AsDict();
+        return renderer::MakeTileViewport(tile.at("z").AsInt(), tile.at("x").AsInt(), tile.at("y").AsInt());
+    }
+    return std::nullopt;
+}
+
+template <typename Document>
+Document LoadDocument(std::string text) {
+    Document document(std::move(text));
+    typename Document::Builder builder(document);
+    json::Parse(document.GetText(), builder);
+    builder.Finish();
+    return document;
+}
+
+template <typename Document>
+Document LoadStreaming(std::istream& input, TransportCatalogue& db) {
+    // Текст не передаётся документу: без base_requests в нём остаётся немного строк,
+    // и их дешевле скопировать в документ, чем держать весь входной текст
+    const std::string text{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    Document document({});
+    typename Document::Builder builder(document);
+    CatalogueLoader loader(db, builder);
+    json::Parse(text, loader);
+    builder.Finish();
+    return document;
+}
+
+} // namespace
+
+template <typename Document>
+BasicJsonReader<Document>::BasicJsonReader(std::istream& input)
+    : input_(LoadDocument<Document>(std::string{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() })) {
+}
+
+template <typename Document>
+BasicJsonReader<Document>::BasicJsonReader(std::istream& input, TransportCatalogue& db)
+    : input_(LoadStreaming<Document>(input, db)) {
+}
+
+template <typename Document>
+typename BasicJsonReader<Document>::Node BasicJsonReader<Document>::GetBaseRequests() const {
     return input_.GetRoot().AsDict().at("base_requests");
 }
 
-const json::Node& JsonReader::GetStatRequests() const {
+template <typename Document>
+typename BasicJsonReader<Document>::Node BasicJsonReader<Document>::GetStatRequests() const {
     return input_.GetRoot().AsDict().at("stat_requests");
 }
 
-const json::Node& JsonReader::GetRenderSettings() const {
+template <typename Document>
+typename BasicJsonReader<Document>::Node BasicJsonReader<Document>::GetRenderSettings() const {
     return input_.GetRoot().AsDict().at("render_settings");
 }
 
-void JsonReader::FillCatalogue(TransportCatalogue& db)  {
-    const json::Array& arr = GetBaseRequests().AsArray();
-    for (auto& request_stops : arr) {
+template <typename Document>
+typename BasicJsonReader<Document>::Node BasicJsonReader<Document>::GetSerializationSettings() const {
+    return input_.GetRoot().AsDict().at("serialization_settings");
+}
+
+template <typename Document>
+typename BasicJsonReader<Document>::Node BasicJsonReader<Document>::GetRoutingSettings() const {
+    return input_.GetRoot().AsDict().at("routing_settings");
+}
+
+template <typename Document>
+bool BasicJsonReader<Document>::HasRoutingSettings() const {
+    return input_.GetRoot().AsDict().count("routing_settings") > 0;
+}
+
+template <typename Document>
+void BasicJsonReader<Document>::FillCatalogue(TransportCatalogue& db)  {
+    const Array arr = GetBaseRequests().AsArray();
+    for (const auto& request_stops : arr) {
         const auto& request_stops_map = request_stops.AsDict();
         const auto& type = request_stops_map.at("type").AsString();
         if (type == "Stop") {
@@ -24,41 +397,49 @@ void JsonReader::FillCatalogue(TransportCatalogue& db)  {
     }
     FillStopDistances(db);
     
-    for (auto& request_bus : arr) {
+    std::vector<std::tuple<std::string_view, std::vector<StopPtr>, bool>> routes;
+    for (const auto& request_bus : arr) {
         const auto& request_bus_map = request_bus.AsDict();
         const auto& type = request_bus_map.at("type").AsString();
         if (type == "Bus") {
-            auto [bus_number, stops, circular_route] = FillRoute(request_bus_map, db);
-            db.AddRoute(bus_number, stops, circular_route);
+            routes.push_back(FillRoute(request_bus_map, db));
         }
     }
+    db.AddRoutes(routes);
 }
 
-std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> JsonReader::FillStop(const json::Dict& request_map) const {
+template <typename Document>
+std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> BasicJsonReader<Document>::FillStop(const Dict& request_map) const {
     std::string_view stop_name = request_map.at("name").AsString();
     geo::Coordinates coordinates = { request_map.at("latitude").AsDouble(), request_map.at("longitude").AsDouble() };
     std::map<std::string_view, int> stop_distances;
-    auto& distances = request_map.at("road_distances").AsDict();
-    for (auto& [stop_name, dist] : distances) {
+    const auto distances = request_map.at("road_distances").AsDict();
+    for (const auto& [stop_name, dist] : distances) {
         stop_distances.emplace(stop_name, dist.AsInt());
     }
     return std::make_tuple(stop_name, coordinates, stop_distances);
 }
 
-std::tuple<std::string_view, std::vector<StopPtr>, bool> JsonReader::FillRoute(const json::Dict& request_map, TransportCatalogue& db) const {
+template <typename Document>
+std::tuple<std::string_view, std::vector<StopPtr>, bool> BasicJsonReader<Document>::FillRoute(const Dict& request_map, TransportCatalogue& db) const {
     std::string_view bus_name = request_map.at("name").AsString();
     std::vector<StopPtr> stops;
-    for (auto& stop : request_map.at("stops").AsArray()) {
-        stops.push_back(db.GetStop(stop.AsString()));
+    for (const auto& stop : request_map.at("stops").AsArray()) {
+        const StopPtr route_stop = db.GetStop(stop.AsString());
+        if (!route_stop) {
+            throw std::logic_error("Unknown stop "s + std::string(stop.AsString()));
+        }
+        stops.push_back(route_stop);
     }
     bool circular_route = request_map.at("is_roundtrip").AsBool();
 
     return std::make_tuple(bus_name, stops, circular_route);
 }
 
-void JsonReader::FillStopDistances(TransportCatalogue& db) const {
-    const json::Array& arr = GetBaseRequests().AsArray();
-    for (auto& request_stops: arr) {
+template <typename Document>
+void BasicJsonReader<Document>::FillStopDistances(TransportCatalogue& db) const {
+    const Array arr = GetBaseRequests().AsArray();
+    for (const auto& request_stops : arr) {
         const auto& request_stops_map = request_stops.AsDict();
         const auto& type = request_stops_map.at("type").AsString();
         if (type == "Stop") {
@@ -66,13 +447,17 @@ void JsonReader::FillStopDistances(TransportCatalogue& db) const {
             for (auto& [to_name, dist] : stop_distances) {
                 auto from = db.GetStop(stop_name);
                 auto to = db.GetStop(to_name);
+                if (!to) {
+                    throw std::logic_error("Unknown stop "s + std::string(to_name));
+                }
                 db.SetStopDistance(from, to, dist);
             }
         }
     }
 }
 
-svg::Color JsonReader::FillColor(const json::Node& node) const {
+template <typename Document>
+svg::Color BasicJsonReader<Document>::FillColor(const Node& node) const {
     if (node.IsArray()) {
         if (node.AsArray().size() == 3) {
             svg::Rgb rgb;
@@ -94,14 +479,15 @@ svg::Color JsonReader::FillColor(const json::Node& node) const {
         }
     }
     else if (node.IsString()) {
-        return node.AsString();
+        return std::string(node.AsString());
     }
     else { 
         throw std::logic_error("Wrong underlayer color"); 
     }
 }
 
-renderer::MapRenderer JsonReader::FillRenderSettings(const json::Dict& request_map) const {
+template <typename Document>
+renderer::MapRenderer BasicJsonReader<Document>::FillRenderSettings(const Dict& request_map) const {
     renderer::RenderSettings render_settings;
     render_settings.width = request_map.at("width").AsDouble();
     render_settings.height = request_map.at("height").AsDouble();
@@ -110,109 +496,292 @@ renderer::MapRenderer JsonReader::FillRenderSettings(const json::Dict& request_m
     render_settings.line_width = request_map.at("line_width").AsDouble();
     
     render_settings.bus_label_font_size = request_map.at("bus_label_font_size").AsInt();
-    const json::Array& bus_label_offset = request_map.at("bus_label_offset").AsArray();
+    const Array bus_label_offset = request_map.at("bus_label_offset").AsArray();
     render_settings.bus_label_offset = {bus_label_offset[0].AsDouble(),
                                         bus_label_offset[1].AsDouble()};
     
     render_settings.stop_label_font_size = request_map.at("stop_label_font_size").AsInt();
-    const json::Array& stop_label_offset = request_map.at("stop_label_offset").AsArray();
+    const Array stop_label_offset = request_map.at("stop_label_offset").AsArray();
     render_settings.stop_label_offset = {stop_label_offset[0].AsDouble(),
                                          stop_label_offset[1].AsDouble() };
     
     render_settings.underlayer_color = FillColor(request_map.at("underlayer_color"));
     render_settings.underlayer_width = request_map.at("underlayer_width").AsDouble();
     
-    const json::Array& color_palette = request_map.at("color_palette").AsArray();
+    const Array color_palette = request_map.at("color_palette").AsArray();
     render_settings.color_palette.reserve(color_palette.size());
     for (const auto& color_element : color_palette) {
         render_settings.color_palette.emplace_back(FillColor(color_element));
     }
+    if (const auto it = request_map.find("simplify_tolerance"); it != request_map.end()) {
+        render_settings.simplify_tolerance = it->second.AsDouble();
+    }
+    if (const auto it = request_map.find("compact_output"); it != request_map.end()) {
+        const Dict compact = it->second.AsDict();
+        svg::CompactOptions options;
+        if (const auto precision = compact.find("precision"); precision != compact.end()) {
+            options.precision = precision->second.AsInt();
+            if (options.precision < 0 || options.precision > MAX_COMPACT_PRECISION) {
+                throw std::invalid_argument("compact_output precision is out of range");
+            }
+        }
+        if (const auto relative_paths = compact.find("relative_paths"); relative_paths != compact.end()) {
+            options.relative_paths = relative_paths->second.AsBool();
+        }
+        render_settings.compact_output = options;
+    }
     
     return render_settings;
 }
 
-void JsonReader::ProcessRequests(const json::Node& stat_requests, RequestHandler& rh, std::ostream& output) const {
-    json::Array result;
-    for (auto& request : stat_requests.AsArray()) {
-        const auto& request_map = request.AsDict();
-        const auto& type = request_map.at("type").AsString();
-        if (type == "Stop") result.push_back(MakeStop(request_map, rh).AsDict());
-        if (type == "Bus") result.push_back(MakeRoute(request_map, rh).AsDict());
-        if (type == "Map") result.push_back(MakeMap(request_map, rh).AsDict());
+template <typename Document>
+transport_router::RoutingSettings BasicJsonReader<Document>::FillRoutingSettings(const Dict& request_map) const {
+    transport_router::RoutingSettings routing_settings;
+    routing_settings.bus_wait_time = request_map.at("bus_wait_time").AsInt();
+    routing_settings.bus_velocity = request_map.at("bus_velocity").AsDouble();
+    if (const auto it = request_map.find("landmark_count"); it != request_map.end()) {
+        routing_settings.landmark_count = it->second.AsInt();
+    }
+    return routing_settings;
+}
+
+template <typename Document>
+void BasicJsonReader<Document>::ProcessRequests(const Node& stat_requests, const RequestHandler& rh, std::ostream& output,
+                                 size_t threads_count) const {
+    // Узлы запросов собираются заранее: у ленивого документа доступ по индексу линейный
+    const Array array = stat_requests.AsArray();
+    const std::vector<Node> requests(array.begin(), array.end());
+    
+    // Ответы выводятся в исходном порядке, как только готовы все предыдущие.
+    // Поток, ответивший на очередной запрос, сам дописывает его в output вместе
+    // с уже готовыми следующими; остальные ответы ждут своей очереди в pending
+    std::string buffer;
+    json::Writer writer(buffer);
+    writer.StartArray();
+    std::vector<std::string> pending(requests.size());
+    std::vector<char> ready(requests.size());
+    size_t next_output = 0;
+    std::mutex output_mutex;
+    
+    const auto write_response = [&](const std::string& response) {
+        // Запрос без ответа оставляет строку пустой
+        if (!response.empty()) {
+            writer.Raw(response);
+        }
+        ++next_output;
+    };
+    
+    // Потоки разбирают запросы по одному, поэтому тяжёлые запросы Map и Route
+    // не задерживают остальные
+    std::atomic<size_t> next_request{ 0 };
+    std::exception_ptr error;
+    auto worker = [&] {
+        std::string response;
+        try {
+            for (size_t i = next_request++; i < requests.size(); i = next_request++) {
+                // Ответ пишется в собственный буфер, поэтому ответ запроса, который
+                // не удалось выполнить, отбрасывается целиком и заменяется ошибкой
+                std::optional<std::string> failure;
+                try {
+                    response.clear();
+                    json::Writer response_writer(response, RESPONSE_INDENT);
+                    MakeResponse(requests[i].AsDict(), rh, response_writer);
+                }
+                catch (const std::exception& e) {
+                    failure = e.what();
+                }
+                catch (...) {
+                    failure = "internal error";
+                }
+                if (failure) {
+                    response.clear();
+                    json::Writer error_writer(response, RESPONSE_INDENT);
+                    WriteError(error_writer, *failure, ReadRequestId(requests[i]));
+                }
+                
+                std::lock_guard guard(output_mutex);
+                if (i != next_output) {
+                    pending[i] = std::move(response);
+                    ready[i] = true;
+                    continue;
+                }
+                write_response(response);
+                while (next_output < requests.size() && ready[next_output]) {
+                    write_response(pending[next_output]);
+                    pending[next_output - 1] = {};
+                }
+                output.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        catch (...) {
+            std::lock_guard guard(output_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next_request = requests.size();
+        }
+    };
+    
+    threads_count = std::max<size_t>(1, std::min(threads_count, requests.size()));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threads_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // Сбой вне обработки запроса (например, нехватка памяти) прерывает вывод, но
+    // массив всё равно закрывается: в output остаётся корректный JSON с готовыми ответами
+    writer.EndArray();
+    output.write(buffer.data(), buffer.size());
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+template <typename Document>
+size_t BasicJsonReader<Document>::GetThreadCount() const {
+    const auto& root = input_.GetRoot().AsDict();
+    if (const auto it = root.find("processing_settings"); it != root.end()) {
+        const auto& settings = it->second.AsDict();
+        if (const auto threads = settings.find("thread_count"); threads != settings.end()) {
+            return static_cast<size_t>(std::max(1, threads->second.AsInt()));
+        }
     }
+    return 1;
+}
 
-    json::Print(json::Document{result}, output);
+template <typename Document>
+bool BasicJsonReader<Document>::MakeResponse(const Dict& request_map, const RequestHandler& rh, json::Writer& writer) const {
+    const auto& type = request_map.at("type").AsString();
+    if (type == "Stop") MakeStop(request_map, rh, writer);
+    else if (type == "Bus") MakeRoute(request_map, rh, writer);
+    else if (type == "Map") MakeMap(request_map, rh, writer);
+    else if (type == "Route") MakeTransportRoute(request_map, rh, writer);
+    else return false;
+    return true;
 }
 
-const json::Node JsonReader::MakeRoute(const json::Dict& request_map, RequestHandler& rh) const {
-    json::Node result;
-    const std::string& route_number = request_map.at("name").AsString();
+// Ключи ответов записываются в алфавитном порядке, которого требует json::Writer
+
+template <typename Document>
+void BasicJsonReader<Document>::MakeRoute(const Dict& request_map, const RequestHandler& rh, json::Writer& writer) const {
+    const std::string_view route_number = request_map.at("name").AsString();
     const int id = request_map.at("id").AsInt();
     
+    writer.StartDict();
     if (!rh.IsBusNumber(route_number)) {
-        result = json::Builder{}
-                    .StartDict()
-                        .Key("request_id").Value(id)
-                        .Key("error_message").Value("not found")
-                    .EndDict()
-                .Build();
+        writer.Key("error_message"); writer.String("not found");
+        writer.Key("request_id"); writer.Int(id);
     }
     else {
         const auto& route_info = rh.GetBusStat(route_number);
-        result = json::Builder{}
-                    .StartDict()
-                        .Key("request_id").Value(id)
-                        .Key("curvature").Value(route_info->curvature)
-                        .Key("route_length").Value(route_info->route_length)
-                        .Key("stop_count").Value(static_cast<int>(route_info->stops_count))
-                        .Key("unique_stop_count").Value(static_cast<int>(route_info->unique_stops_count))
-                    .EndDict()
-                .Build();
-    }
-    return result;
-}
-
-const json::Node JsonReader::MakeStop(const json::Dict& request_map, RequestHandler& rh) const {
-    json::Node result;
-    const std::string& stop_name = request_map.at("name").AsString();
+        writer.Key("curvature"); writer.Double(route_info->curvature);
+        writer.Key("request_id"); writer.Int(id);
+        writer.Key("route_length"); writer.Double(route_info->route_length);
+        writer.Key("stop_count"); writer.Int(static_cast<int>(route_info->stops_count));
+        writer.Key("unique_stop_count"); writer.Int(static_cast<int>(route_info->unique_stops_count));
+    }
+    writer.EndDict();
+}
+
+template <typename Document>
+void BasicJsonReader<Document>::MakeStop(const Dict& request_map, const RequestHandler& rh, json::Writer& writer) const {
+    const std::string_view stop_name = request_map.at("name").AsString();
     const int id = request_map.at("id").AsInt();
     
+    writer.StartDict();
     if (!rh.IsStopName(stop_name)) {
-        result = json::Builder{}
-                    .StartDict()
-                        .Key("request_id").Value(id)
-                        .Key("error_message").Value("not found")
-                    .EndDict()
-                .Build();
+        writer.Key("error_message"); writer.String("not found");
     }
     else {
-        json::Array buses;
+        writer.Key("buses");
+        writer.StartArray();
         for (const auto& bus : rh.GetBusesByStop(stop_name)) {
-            buses.push_back(std::string(bus));
+            writer.String(bus);
         }
-        result = json::Builder{}
-                    .StartDict()
-                        .Key("request_id").Value(id)
-                        .Key("buses").Value(buses)
-                    .EndDict()
-                .Build();
+        writer.EndArray();
     }
-    return result;
+    writer.Key("request_id"); writer.Int(id);
+    writer.EndDict();
 }
 
-const json::Node JsonReader::MakeMap(const json::Dict& request_map, RequestHandler& rh) const {
-    json::Node result;
+template <typename Document>
+void BasicJsonReader<Document>::MakeMap(const Dict& request_map, const RequestHandler& rh, json::Writer& writer) const {
     const int id = request_map.at("id").AsInt();
-    std::ostringstream strm;
-    svg::Document map = rh.RenderMap();
-    map.Render(strm);
     
-    result = json::Builder{}
-                .StartDict()
-                    .Key("request_id").Value(id)
-                    .Key("map").Value(strm.str())
-                .EndDict()
-            .Build();
+    // Ошибки области запроса проверяются до записи ответа: неверная область
+    // даёт ответ с error_message, а не прерывает обработку остальных запросов.
+    // Допуск упрощения линий можно задать и для области, и для полной карты
+    std::optional<renderer::Viewport> viewport;
+    std::optional<double> simplify_tolerance;
+    try {
+        viewport = ReadViewport(request_map);
+        if (const auto it = request_map.find("simplify_tolerance"); it != request_map.end()) {
+            simplify_tolerance = it->second.AsDouble();
+        }
+    }
+    catch (const std::logic_error& e) {
+        WriteError(writer, e.what(), id);
+        return;
+    }
+    if ((viewport || simplify_tolerance) && !rh.CanRenderOnDemand()) {
+        WriteError(writer, "viewport and simplify_tolerance require a transport catalogue", id);
+        return;
+    }
+    
+    writer.StartDict();
+    writer.Key("map");
+    if (viewport) {
+        writer.StreamString([&rh, &viewport, simplify_tolerance](std::ostream& out) {
+            rh.RenderMap(*viewport, out, simplify_tolerance);
+        });
+    }
+    else {
+        // Полная карта рисуется и экранируется один раз на версию справочника;
+        // заново рисуется только карта со своим допуском упрощения
+        writer.EscapedString(*rh.GetMapJsonString(simplify_tolerance));
+    }
+    writer.Key("request_id"); writer.Int(id);
+    writer.EndDict();
+}
+
+template <typename Document>
+void BasicJsonReader<Document>::MakeTransportRoute(const Dict& request_map, const RequestHandler& rh, json::Writer& writer) const {
+    const int id = request_map.at("id").AsInt();
+    const auto route = rh.BuildRoute(request_map.at("from").AsString(), request_map.at("to").AsString());
     
-    return result;
-}
\ No newline at end of file
+    writer.StartDict();
+    if (!route) {
+        writer.Key("error_message"); writer.String("not found");
+        writer.Key("request_id"); writer.Int(id);
+    }
+    else {
+        writer.Key("items");
+        writer.StartArray();
+        for (const auto& item : route->items) {
+            writer.StartDict();
+            if (item.type == transport_router::RouteItem::Type::WAIT) {
+                writer.Key("stop_name"); writer.String(item.name);
+                writer.Key("time"); writer.Double(item.time);
+                writer.Key("type"); writer.String("Wait");
+            }
+            else {
+                writer.Key("bus"); writer.String(item.name);
+                writer.Key("span_count"); writer.Int(item.span_count);
+                writer.Key("time"); writer.Double(item.time);
+                writer.Key("type"); writer.String("Bus");
+            }
+            writer.EndDict();
+        }
+        writer.EndArray();
+        writer.Key("request_id"); writer.Int(id);
+        writer.Key("total_time"); writer.Double(route->total_time);
+    }
+    writer.EndDict();
+}
+
+template class BasicJsonReader<json::ArenaDocument>;
+template class BasicJsonReader<json::TapeDocument>;
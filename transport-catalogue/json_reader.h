@@ -1,40 +1,74 @@
 #pragma once
 
 #include "json.h"
-#include "json_builder.h"
+#include "json_arena.h"
+#include "json_tape.h"
+#include "json_writer.h"
 #include "map_renderer.h" 
 #include "request_handler.h" 
 #include "transport_catalogue.h"
+#include "transport_router.h"
 
 #include <iostream>
+#include <optional>
+#include <type_traits>
+#include <utility>
 
 using namespace transport_catalogue; 
 using namespace domain;
 
-class JsonReader {
+/*
+ * Читает входной JSON и отвечает на запросы. Document — представление входа:
+ * json::ArenaDocument (компактный DOM) или json::TapeDocument (ленивая лента,
+ * значения достаются по запросу). Обе реализации собраны в json_reader.cpp
+ */
+template <typename Document>
+class BasicJsonReader {
 public:
-    JsonReader(std::istream& input)
-        : input_(json::Load(input)) {
-    }
+    using Node = std::decay_t<decltype(std::declval<const Document&>().GetRoot())>;
+    using Dict = decltype(std::declval<const Node&>().AsDict());
+    using Array = decltype(std::declval<const Node&>().AsArray());
 
-    const json::Node& GetBaseRequests() const;
-    const json::Node& GetStatRequests() const;
-    const json::Node& GetRenderSettings() const;
+    explicit BasicJsonReader(std::istream& input);
+    // Записи base_requests применяются к db по ходу разбора и не сохраняются,
+    // поэтому GetBaseRequests и FillCatalogue для такого объекта недоступны
+    BasicJsonReader(std::istream& input, TransportCatalogue& db);
+
+    Node GetBaseRequests() const;
+    Node GetStatRequests() const;
+    Node GetRenderSettings() const;
+    Node GetSerializationSettings() const;
+    Node GetRoutingSettings() const;
+    bool HasRoutingSettings() const;
 
     void FillCatalogue(TransportCatalogue& db);
-    std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> FillStop(const json::Dict& request_map) const; 
-    std::tuple<std::string_view, std::vector<StopPtr>, bool> FillRoute(const json::Dict& request_map, TransportCatalogue& db) const; 
+    std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> FillStop(const Dict& request_map) const; 
+    std::tuple<std::string_view, std::vector<StopPtr>, bool> FillRoute(const Dict& request_map, TransportCatalogue& db) const; 
     void FillStopDistances(TransportCatalogue& db) const;
-    svg::Color FillColor(const json::Node& node) const;
-    renderer::MapRenderer FillRenderSettings(const json::Dict& request_map) const;
+    svg::Color FillColor(const Node& node) const;
+    renderer::MapRenderer FillRenderSettings(const Dict& request_map) const;
+    transport_router::RoutingSettings FillRoutingSettings(const Dict& request_map) const;
     
-    void ProcessRequests(const json::Node& stat_requests, RequestHandler& rh, std::ostream& output) const;
+    // Запросы обрабатываются в threads_count потоков; ответы выводятся в исходном порядке
+    // по мере готовности, без построения общего дерева
+    void ProcessRequests(const Node& stat_requests, const RequestHandler& rh, std::ostream& output,
+                         size_t threads_count = 1) const;
+    size_t GetThreadCount() const;
 
-    const json::Node MakeRoute(const json::Dict& request_map, RequestHandler& rh) const;
-    const json::Node MakeStop(const json::Dict& request_map, RequestHandler& rh) const;
-    const json::Node MakeMap(const json::Dict& request_map, RequestHandler& rh) const;
+    // Ответ дописывается в writer; false, если запрос не требует ответа
+    bool MakeResponse(const Dict& request_map, const RequestHandler& rh, json::Writer& writer) const;
+    void MakeRoute(const Dict& request_map, const RequestHandler& rh, json::Writer& writer) const;
+    void MakeStop(const Dict& request_map, const RequestHandler& rh, json::Writer& writer) const;
+    void MakeMap(const Dict& request_map, const RequestHandler& rh, json::Writer& writer) const;
+    void MakeTransportRoute(const Dict& request_map, const RequestHandler& rh, json::Writer& writer) const;
 
 private:
-    json::Document input_;
-    json::Node dummy_ = nullptr;
-};
\ No newline at end of file
+    Document input_;
+};
+
+extern template class BasicJsonReader<json::ArenaDocument>;
+extern template class BasicJsonReader<json::TapeDocument>;
+
+using JsonReader = BasicJsonReader<json::ArenaDocument>;
+// Для входа, из которого читается лишь несколько известных полей
+using LazyJsonReader = BasicJsonReader<json::TapeDocument>;
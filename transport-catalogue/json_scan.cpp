@@ -0,0 +1,171 @@
+#include "json_scan.h"
+
+#if !defined(JSON_SCAN_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define JSON_SCAN_SIMD
+#endif
+
+namespace json::scan {
+
+namespace {
+
+using namespace std::literals;
+
+// Классы символов: IsMember проверяет один байт, Match — блок из 16 или 32 байт
+// и возвращает маску, где бит i установлен, если байт i относится к классу.
+// Диапазон [lo, lo + n) проверяется беззнаково: min(x - lo, n - 1) == x - lo
+struct Spaces {
+    static bool IsMember(char c) {
+        return c == ' ' || static_cast<unsigned char>(c - '\t') < 5;
+    }
+#ifdef JSON_SCAN_SIMD
+    static unsigned Match(__m128i block) {
+        const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+        return _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                                              _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted)));
+    }
+    __attribute__((target("avx2")))
+    static unsigned Match(__m256i block) {
+        const __m256i shifted = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+        return _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+                                                    _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted)));
+    }
+#endif
+};
+
+struct StringBody {
+    static bool IsMember(char c) {
+        return c != '"' && c != '\\' && c != '\n' && c != '\r';
+    }
+#ifdef JSON_SCAN_SIMD
+    static unsigned Match(__m128i block) {
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('"')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'))),
+            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'))));
+        return ~_mm_movemask_epi8(special);
+    }
+    __attribute__((target("avx2")))
+    static unsigned Match(__m256i block) {
+        const __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\\'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r'))));
+        return ~_mm256_movemask_epi8(special);
+    }
+#endif
+};
+
+struct Digits {
+    static bool IsMember(char c) {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+#ifdef JSON_SCAN_SIMD
+    static unsigned Match(__m128i block) {
+        const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8('0'));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(9)), shifted));
+    }
+    __attribute__((target("avx2")))
+    static unsigned Match(__m256i block) {
+        const __m256i shifted = _mm256_sub_epi8(block, _mm256_set1_epi8('0'));
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(9)), shifted));
+    }
+#endif
+};
+
+template <typename Class>
+const char* SkipScalar(const char* first, const char* last) {
+    while (first != last && Class::IsMember(*first)) {
+        ++first;
+    }
+    return first;
+}
+
+#ifdef JSON_SCAN_SIMD
+
+// Ищет первый байт не из класса в блоке из 16 байт; возвращает nullptr, если таких нет
+template <typename Class>
+const char* FindInBlock16(const char* first) {
+    const unsigned mask = ~Class::Match(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first))) & 0xFFFFu;
+    return mask != 0 ? first + __builtin_ctz(mask) : nullptr;
+}
+
+template <typename Class>
+const char* SkipSse2(const char* first, const char* last) {
+    for (; last - first >= 16; first += 16) {
+        if (const char* found = FindInBlock16<Class>(first)) {
+            return found;
+        }
+    }
+    return SkipScalar<Class>(first, last);
+}
+
+// Большинство лексем JSON короче 16 байт, поэтому сначала проверяется один
+// блок SSE2, и только длинные участки просматриваются по 32 байта
+template <typename Class>
+__attribute__((target("avx2")))
+const char* SkipAvx2(const char* first, const char* last) {
+    if (last - first >= 16) {
+        if (const char* found = FindInBlock16<Class>(first)) {
+            return found;
+        }
+        first += 16;
+    }
+    for (; last - first >= 32; first += 32) {
+        const unsigned mask = ~Class::Match(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first)));
+        if (mask != 0) {
+            return first + __builtin_ctz(mask);
+        }
+    }
+    return SkipSse2<Class>(first, last);
+}
+
+#endif
+
+Kernels SelectKernels() {
+#ifdef JSON_SCAN_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return { "avx2"sv, SkipAvx2<Spaces>, SkipAvx2<StringBody>, SkipAvx2<Digits> };
+    }
+    // SSE2 входит в базовый набор x86-64
+    return { "sse2"sv, SkipSse2<Spaces>, SkipSse2<StringBody>, SkipSse2<Digits> };
+#else
+    return { "scalar"sv, SkipScalar<Spaces>, SkipScalar<StringBody>, SkipScalar<Digits> };
+#endif
+}
+
+const Kernels& GetKernels() {
+    static const Kernels kernels = SelectKernels();
+    return kernels;
+}
+
+} // namespace
+
+const char* SkipSpaces(const char* first, const char* last) {
+    return GetKernels().skip_spaces(first, last);
+}
+
+const char* SkipStringBody(const char* first, const char* last) {
+    return GetKernels().skip_string_body(first, last);
+}
+
+const char* SkipDigits(const char* first, const char* last) {
+    return GetKernels().skip_digits(first, last);
+}
+
+std::string_view GetKernelName() {
+    return GetKernels().name;
+}
+
+std::vector<Kernels> GetSupportedKernels() {
+    std::vector<Kernels> result = { { "scalar"sv, SkipScalar<Spaces>, SkipScalar<StringBody>, SkipScalar<Digits> } };
+#ifdef JSON_SCAN_SIMD
+    __builtin_cpu_init();
+    result.push_back({ "sse2"sv, SkipSse2<Spaces>, SkipSse2<StringBody>, SkipSse2<Digits> });
+    if (__builtin_cpu_supports("avx2")) {
+        result.push_back({ "avx2"sv, SkipAvx2<Spaces>, SkipAvx2<StringBody>, SkipAvx2<Digits> });
+    }
+#endif
+    return result;
+}
+
+} // namespace json::scan
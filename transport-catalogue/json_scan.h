@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace json::scan {
+
+/*
+ * Ядра поиска для разбора JSON. Каждая функция возвращает указатель на первый
+ * символ в [first, last), который не относится к своему классу, либо last.
+ * Реализация (AVX2, SSE2 или побайтовая) выбирается один раз при первом вызове
+ * по возможностям процессора. Определение JSON_SCAN_NO_SIMD при сборке
+ * оставляет только побайтовую реализацию
+ */
+
+// Пробельные символы: пробел, \t, \n, \v, \f, \r
+const char* SkipSpaces(const char* first, const char* last);
+// Тело строки: всё, кроме '"', '\\', '\n' и '\r'
+const char* SkipStringBody(const char* first, const char* last);
+// Десятичные цифры
+const char* SkipDigits(const char* first, const char* last);
+
+// Выбранная реализация: "avx2", "sse2" или "scalar"
+std::string_view GetKernelName();
+
+// Ядра одной реализации
+struct Kernels {
+    std::string_view name;
+    const char* (*skip_spaces)(const char*, const char*);
+    const char* (*skip_string_body)(const char*, const char*);
+    const char* (*skip_digits)(const char*, const char*);
+};
+
+// Реализации, которые поддерживает процессор, начиная с побайтовой; для замеров
+std::vector<Kernels> GetSupportedKernels();
+
+} // namespace json::scan
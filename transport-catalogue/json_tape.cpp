@@ -0,0 +1,408 @@
+#include "json_tape.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace json {
+
+using namespace std::literals;
+
+namespace {
+
+// Словари до такого размера проверяются на дубликаты ключей попарно
+const size_t SMALL_DICT_SIZE = 8;
+
+enum EntryType : uint8_t {
+    NULL_VALUE,
+    BOOL,
+    INT,
+    DOUBLE,
+    STRING,
+    KEY,
+    ARRAY,
+    DICT,
+};
+
+} // namespace
+
+/*
+ * Запись ленты занимает 16 байт. Для строк и ключей size — длина, payload —
+ * смещение в тексте либо, если external, в буфере скопированных строк.
+ * Для контейнеров size — число элементов (пар для словаря), payload — позиция
+ * записи за последним элементом. Для чисел и bool payload хранит само значение.
+ * Словарь записывается парами: запись KEY, затем записи значения
+ */
+struct Tape {
+    struct Entry {
+        uint8_t type;
+        bool external;
+        uint32_t size;
+        uint64_t payload;
+    };
+
+    std::string text;
+    std::string external;
+    std::vector<Entry> entries;
+
+    const Entry& At(size_t index) const {
+        return entries[index];
+    }
+
+    // Позиция записи, следующей за значением index вместе со всеми вложенными
+    size_t Next(size_t index) const {
+        const Entry& entry = entries[index];
+        return entry.type == ARRAY || entry.type == DICT ? entry.payload : index + 1;
+    }
+
+    std::string_view GetString(size_t index) const {
+        const Entry& entry = entries[index];
+        const std::string& source = entry.external ? external : text;
+        return { source.data() + entry.payload, entry.size };
+    }
+};
+
+// ---------- TapeNode ------------------
+
+bool TapeNode::IsNull() const {
+    return tape_->At(index_).type == NULL_VALUE;
+}
+
+bool TapeNode::IsBool() const {
+    return tape_->At(index_).type == BOOL;
+}
+
+bool TapeNode::IsInt() const {
+    return tape_->At(index_).type == INT;
+}
+
+bool TapeNode::IsPureDouble() const {
+    return tape_->At(index_).type == DOUBLE;
+}
+
+bool TapeNode::IsDouble() const {
+    return IsInt() || IsPureDouble();
+}
+
+bool TapeNode::IsString() const {
+    return tape_->At(index_).type == STRING;
+}
+
+bool TapeNode::IsArray() const {
+    return tape_->At(index_).type == ARRAY;
+}
+
+bool TapeNode::IsDict() const {
+    return tape_->At(index_).type == DICT;
+}
+
+bool TapeNode::AsBool() const {
+    if (!IsBool()) {
+        throw std::logic_error("Not a bool"s);
+    }
+    return tape_->At(index_).payload != 0;
+}
+
+int TapeNode::AsInt() const {
+    if (!IsInt()) {
+        throw std::logic_error("Not an int"s);
+    }
+    return static_cast<int>(static_cast<int64_t>(tape_->At(index_).payload));
+}
+
+double TapeNode::AsDouble() const {
+    if (!IsDouble()) {
+        throw std::logic_error("Not a double"s);
+    }
+    if (IsInt()) {
+        return AsInt();
+    }
+    double value;
+    std::memcpy(&value, &tape_->At(index_).payload, sizeof(value));
+    return value;
+}
+
+std::string_view TapeNode::AsString() const {
+    if (!IsString()) {
+        throw std::logic_error("Not a string"s);
+    }
+    return tape_->GetString(index_);
+}
+
+TapeArray TapeNode::AsArray() const {
+    if (!IsArray()) {
+        throw std::logic_error("Not an array"s);
+    }
+    return { tape_, index_ };
+}
+
+TapeDict TapeNode::AsDict() const {
+    if (!IsDict()) {
+        throw std::logic_error("Not a dict"s);
+    }
+    return { tape_, index_ };
+}
+
+// ---------- TapeArray ------------------
+
+TapeArray::Iterator& TapeArray::Iterator::operator++() {
+    index_ = tape_->Next(index_);
+    return *this;
+}
+
+TapeArray::TapeArray(const Tape* tape, size_t index)
+    : tape_(tape)
+    , index_(index) {
+}
+
+TapeArray::Iterator TapeArray::begin() const {
+    return { tape_, index_ + 1 };
+}
+
+TapeArray::Iterator TapeArray::end() const {
+    return { tape_, tape_->At(index_).payload };
+}
+
+size_t TapeArray::size() const {
+    return tape_->At(index_).size;
+}
+
+bool TapeArray::empty() const {
+    return size() == 0;
+}
+
+TapeNode TapeArray::operator[](size_t index) const {
+    size_t position = index_ + 1;
+    for (; index > 0; --index) {
+        position = tape_->Next(position);
+    }
+    return { tape_, position };
+}
+
+TapeNode TapeArray::at(size_t index) const {
+    if (index >= size()) {
+        throw std::out_of_range("Array index "s + std::to_string(index) + " is out of range"s);
+    }
+    return (*this)[index];
+}
+
+// ---------- TapeDict ------------------
+
+TapeDict::Iterator::Iterator(const Tape* tape, size_t index, size_t end)
+    : tape_(tape)
+    , index_(index)
+    , end_(end)
+    , member_({}, TapeNode(tape, index + 1)) {
+    Load();
+}
+
+TapeDict::Iterator& TapeDict::Iterator::operator++() {
+    index_ = tape_->Next(index_ + 1);
+    Load();
+    return *this;
+}
+
+void TapeDict::Iterator::Load() {
+    if (index_ != end_) {
+        member_ = { tape_->GetString(index_), TapeNode(tape_, index_ + 1) };
+    }
+}
+
+TapeDict::TapeDict(const Tape* tape, size_t index)
+    : tape_(tape)
+    , index_(index) {
+}
+
+TapeDict::Iterator TapeDict::begin() const {
+    return { tape_, index_ + 1, tape_->At(index_).payload };
+}
+
+TapeDict::Iterator TapeDict::end() const {
+    const size_t end = tape_->At(index_).payload;
+    return { tape_, end, end };
+}
+
+size_t TapeDict::size() const {
+    return tape_->At(index_).size;
+}
+
+bool TapeDict::empty() const {
+    return size() == 0;
+}
+
+TapeDict::Iterator TapeDict::find(std::string_view key) const {
+    const size_t end = tape_->At(index_).payload;
+    for (size_t position = index_ + 1; position != end; position = tape_->Next(position + 1)) {
+        if (tape_->GetString(position) == key) {
+            return { tape_, position, end };
+        }
+    }
+    return this->end();
+}
+
+size_t TapeDict::count(std::string_view key) const {
+    return find(key) != end() ? 1 : 0;
+}
+
+TapeNode TapeDict::at(std::string_view key) const {
+    const auto it = find(key);
+    if (it == end()) {
+        throw std::out_of_range("Key '"s + std::string(key) + "' is not found"s);
+    }
+    return it->second;
+}
+
+// ---------- TapeDocument ------------------
+
+TapeDocument::TapeDocument(std::string text)
+    : tape_(std::make_unique<Tape>()) {
+    tape_->text = std::move(text);
+}
+
+TapeDocument::TapeDocument(TapeDocument&&) noexcept = default;
+TapeDocument& TapeDocument::operator=(TapeDocument&&) noexcept = default;
+TapeDocument::~TapeDocument() = default;
+
+std::string_view TapeDocument::GetText() const {
+    return tape_->text;
+}
+
+TapeNode TapeDocument::GetRoot() const {
+    return { tape_.get(), 0 };
+}
+
+size_t TapeDocument::GetTapeSize() const {
+    return tape_->entries.size() * sizeof(Tape::Entry) + tape_->external.size();
+}
+
+// ---------- TapeBuilder ------------------
+
+TapeBuilder::TapeBuilder(TapeDocument& document)
+    : tape_(*document.tape_) {
+    // Запись ленты приходится не реже чем на 16 байт текста даже при длинных
+    // строках и отступах; начинаем с этой оценки, чтобы не переразмещать ленту с нуля
+    tape_.entries.reserve(tape_.text.size() / 16);
+}
+
+void TapeBuilder::Null() {
+    AddValue();
+    tape_.entries.push_back({ NULL_VALUE, false, 0, 0 });
+}
+
+void TapeBuilder::Bool(bool value) {
+    AddValue();
+    tape_.entries.push_back({ BOOL, false, 0, value ? 1u : 0u });
+}
+
+void TapeBuilder::Int(int value) {
+    AddValue();
+    tape_.entries.push_back({ INT, false, 0, static_cast<uint64_t>(static_cast<int64_t>(value)) });
+}
+
+void TapeBuilder::Double(double value) {
+    AddValue();
+    uint64_t payload;
+    std::memcpy(&payload, &value, sizeof(payload));
+    tape_.entries.push_back({ DOUBLE, false, 0, payload });
+}
+
+void TapeBuilder::String(std::string_view value) {
+    AddValue();
+    AddString(STRING, value);
+}
+
+void TapeBuilder::Key(std::string_view key) {
+    ++tape_.entries[frames_.back().index].size;
+    // Запоминаем позицию ключа: буфер скопированных строк ещё может переехать
+    keys_.push_back(tape_.entries.size());
+    AddString(KEY, key);
+}
+
+void TapeBuilder::StartArray() {
+    AddValue();
+    frames_.push_back({ tape_.entries.size(), keys_.size() });
+    tape_.entries.push_back({ ARRAY, false, 0, 0 });
+}
+
+void TapeBuilder::EndArray() {
+    CloseContainer();
+}
+
+void TapeBuilder::StartDict() {
+    AddValue();
+    frames_.push_back({ tape_.entries.size(), keys_.size() });
+    tape_.entries.push_back({ DICT, false, 0, 0 });
+}
+
+void TapeBuilder::EndDict() {
+    const size_t first_key = frames_.back().first_key;
+    // Ключи разобранного словаря известны полностью: проверяем дубликаты.
+    // Небольшие словари сравниваются попарно, большие — через сортировку
+    const auto throw_duplicate = [](std::string_view key) {
+        throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
+    };
+    if (keys_.size() - first_key <= SMALL_DICT_SIZE) {
+        for (size_t i = first_key; i < keys_.size(); ++i) {
+            const std::string_view key = tape_.GetString(keys_[i]);
+            for (size_t j = first_key; j < i; ++j) {
+                if (tape_.GetString(keys_[j]) == key) {
+                    throw_duplicate(key);
+                }
+            }
+        }
+    }
+    else {
+        sorted_keys_.clear();
+        for (size_t i = first_key; i < keys_.size(); ++i) {
+            sorted_keys_.push_back(tape_.GetString(keys_[i]));
+        }
+        std::sort(sorted_keys_.begin(), sorted_keys_.end());
+        if (const auto duplicate = std::adjacent_find(sorted_keys_.begin(), sorted_keys_.end()); duplicate != sorted_keys_.end()) {
+            throw_duplicate(*duplicate);
+        }
+    }
+    keys_.resize(first_key);
+    CloseContainer();
+}
+
+void TapeBuilder::Finish() {
+    if (tape_.entries.empty()) {
+        tape_.entries.push_back({ NULL_VALUE, false, 0, 0 });
+    }
+}
+
+void TapeBuilder::AddValue() {
+    if (!frames_.empty() && tape_.entries[frames_.back().index].type == ARRAY) {
+        ++tape_.entries[frames_.back().index].size;
+    }
+}
+
+void TapeBuilder::AddString(uint8_t type, std::string_view text) {
+    // Строка без escape-последовательностей лежит в тексте документа, остальные копируем
+    const std::string& source = tape_.text;
+    if (text.data() >= source.data() && text.data() + text.size() <= source.data() + source.size()) {
+        tape_.entries.push_back({ type, false, static_cast<uint32_t>(text.size()), static_cast<uint64_t>(text.data() - source.data()) });
+        return;
+    }
+    tape_.entries.push_back({ type, true, static_cast<uint32_t>(text.size()), tape_.external.size() });
+    tape_.external.append(text);
+}
+
+void TapeBuilder::CloseContainer() {
+    tape_.entries[frames_.back().index].payload = tape_.entries.size();
+    frames_.pop_back();
+}
+
+TapeDocument LoadTape(std::istream& input) {
+    return LoadTape(std::string{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() });
+}
+
+TapeDocument LoadTape(std::string text) {
+    TapeDocument document(std::move(text));
+    TapeBuilder builder(document);
+    Parse(document.GetText(), builder);
+    builder.Finish();
+    return document;
+}
+
+} // namespace json
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+// Плоская лента разбора; устройство скрыто в json_tape.cpp
+struct Tape;
+class TapeArray;
+class TapeDict;
+class TapeBuilder;
+
+/*
+ * Ленивое представление документа. Разбор записывает структуру в плоскую ленту:
+ * по записи на значение и ключ, строки хранятся смещениями в тексте, контейнер
+ * помнит число элементов и позицию за своим концом. Узлы, массивы и словари —
+ * лёгкие ссылки на позицию в ленте; строки превращаются в string_view только
+ * при обращении, а поиск ключа просматривает словарь, перепрыгивая вложенные
+ * контейнеры. Методы Is.../As... совпадают с ArenaNode
+ */
+class TapeNode {
+public:
+    TapeNode(const Tape* tape, size_t index)
+        : tape_(tape)
+        , index_(index) {
+    }
+
+    bool IsNull() const;
+    bool IsBool() const;
+    bool IsInt() const;
+    bool IsPureDouble() const;
+    bool IsDouble() const;
+    bool IsString() const;
+    bool IsArray() const;
+    bool IsDict() const;
+
+    bool AsBool() const;
+    int AsInt() const;
+    double AsDouble() const;
+    std::string_view AsString() const;
+    TapeArray AsArray() const;
+    TapeDict AsDict() const;
+
+private:
+    const Tape* tape_;
+    size_t index_;
+};
+
+// Массив: элементы перебираются по порядку, operator[] и at проходят ленту от начала массива
+class TapeArray {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TapeNode;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const TapeNode*;
+        using reference = TapeNode;
+
+        Iterator(const Tape* tape, size_t index)
+            : tape_(tape)
+            , index_(index) {
+        }
+
+        TapeNode operator*() const {
+            return { tape_, index_ };
+        }
+        Iterator& operator++();
+        bool operator==(const Iterator& rhs) const {
+            return index_ == rhs.index_;
+        }
+        bool operator!=(const Iterator& rhs) const {
+            return index_ != rhs.index_;
+        }
+
+    private:
+        const Tape* tape_;
+        size_t index_;
+    };
+
+    TapeArray(const Tape* tape, size_t index);
+
+    Iterator begin() const;
+    Iterator end() const;
+    size_t size() const;
+    bool empty() const;
+    TapeNode operator[](size_t index) const;
+    TapeNode at(size_t index) const;
+
+private:
+    const Tape* tape_;
+    size_t index_;
+};
+
+// Словарь: пары (ключ, значение) в порядке документа; поиск линейный
+class TapeDict {
+public:
+    using Member = std::pair<std::string_view, TapeNode>;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Member;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Member*;
+        using reference = const Member&;
+
+        Iterator(const Tape* tape, size_t index, size_t end);
+
+        const Member& operator*() const {
+            return member_;
+        }
+        const Member* operator->() const {
+            return &member_;
+        }
+        Iterator& operator++();
+        bool operator==(const Iterator& rhs) const {
+            return index_ == rhs.index_;
+        }
+        bool operator!=(const Iterator& rhs) const {
+            return index_ != rhs.index_;
+        }
+
+    private:
+        void Load();
+
+        const Tape* tape_;
+        // Позиция ключа текущей пары
+        size_t index_;
+        size_t end_;
+        Member member_;
+    };
+
+    TapeDict(const Tape* tape, size_t index);
+
+    Iterator begin() const;
+    Iterator end() const;
+    size_t size() const;
+    bool empty() const;
+
+    Iterator find(std::string_view key) const;
+    size_t count(std::string_view key) const;
+    TapeNode at(std::string_view key) const;
+
+private:
+    const Tape* tape_;
+    size_t index_;
+};
+
+/*
+ * Документ владеет лентой и текстом, на который она ссылается. Строки не из
+ * текста документа (раскодированные разборщиком или из другого буфера)
+ * копируются в отдельный буфер ленты. Лента лежит в отдельном блоке, поэтому
+ * узлы переживают перемещение документа. После построения документ только
+ * читается и его можно обходить из нескольких потоков
+ */
+class TapeDocument {
+public:
+    using Builder = TapeBuilder;
+
+    explicit TapeDocument(std::string text);
+    TapeDocument(TapeDocument&&) noexcept;
+    TapeDocument& operator=(TapeDocument&&) noexcept;
+    ~TapeDocument();
+
+    std::string_view GetText() const;
+    TapeNode GetRoot() const;
+    // Байты, занятые лентой и скопированными строками
+    size_t GetTapeSize() const;
+
+private:
+    friend class TapeBuilder;
+
+    std::unique_ptr<Tape> tape_;
+};
+
+// Записывает события разбора в ленту документа
+class TapeBuilder final : public Handler {
+public:
+    explicit TapeBuilder(TapeDocument& document);
+
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void Key(std::string_view key) override;
+    void StartArray() override;
+    void EndArray() override;
+    void StartDict() override;
+    void EndDict() override;
+
+    // Завершает ленту; пустой разбор даёт документ из одного null
+    void Finish();
+
+private:
+    struct Frame {
+        // Позиция записи контейнера в ленте
+        size_t index;
+        // Начало ключей словаря в keys_
+        size_t first_key;
+    };
+
+    void AddValue();
+    void AddString(uint8_t type, std::string_view text);
+    void CloseContainer();
+
+    Tape& tape_;
+    std::vector<Frame> frames_;
+    // Позиции ключей открытых словарей в ленте и буфер для проверки дубликатов
+    std::vector<size_t> keys_;
+    std::vector<std::string_view> sorted_keys_;
+};
+
+// Читает поток целиком и строит по нему ленту
+TapeDocument LoadTape(std::istream& input);
+TapeDocument LoadTape(std::string text);
+
+} // namespace json
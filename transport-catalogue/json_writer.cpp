@@ -0,0 +1,223 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace json {
+
+using namespace std::literals;
+
+namespace {
+
+const int INDENT_STEP = 4;
+// Точность вывода double потоком по умолчанию, с которой печатает json::Print
+const int DOUBLE_PRECISION = 6;
+
+// Дописывает value в output, экранируя те же символы, что и json::Print;
+// участки без таких символов копируются целиком
+void AppendEscaped(std::string& output, std::string_view value) {
+    size_t start = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        const char c = value[i];
+        if (c != '"' && c != '\\' && c != '\r' && c != '\n') {
+            continue;
+        }
+        output.append(value.data() + start, i - start);
+        output += '\\';
+        output += c == '\r' ? 'r' : c == '\n' ? 'n' : c;
+        start = i + 1;
+    }
+    output.append(value.data() + start, value.size() - start);
+}
+
+} // namespace
+
+// ---------- EscapingStreamBuf ------------------
+
+EscapingStreamBuf::EscapingStreamBuf(std::string& output)
+    : output_(output) {
+    setp(buffer_, buffer_ + BUFFER_SIZE);
+}
+
+EscapingStreamBuf::~EscapingStreamBuf() {
+    sync();
+}
+
+EscapingStreamBuf::int_type EscapingStreamBuf::overflow(int_type c) {
+    sync();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize EscapingStreamBuf::xsputn(const char* data, std::streamsize size) {
+    if (size <= epptr() - pptr()) {
+        traits_type::copy(pptr(), data, static_cast<size_t>(size));
+        pbump(static_cast<int>(size));
+        return size;
+    }
+    sync();
+    AppendEscaped(output_, { data, static_cast<size_t>(size) });
+    return size;
+}
+
+int EscapingStreamBuf::sync() {
+    AppendEscaped(output_, { pbase(), static_cast<size_t>(pptr() - pbase()) });
+    setp(buffer_, buffer_ + BUFFER_SIZE);
+    return 0;
+}
+
+// ---------- Writer ------------------
+
+Writer::Writer(std::string& output, int indent)
+    : output_(output)
+    , indent_(indent) {
+}
+
+void Writer::Null() {
+    BeginValue();
+    output_ += "null"sv;
+    EndValue();
+}
+
+void Writer::Bool(bool value) {
+    BeginValue();
+    output_ += value ? "true"sv : "false"sv;
+    EndValue();
+}
+
+void Writer::Int(int value) {
+    BeginValue();
+    char buffer[16];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    output_.append(buffer, result.ptr);
+    EndValue();
+}
+
+void Writer::Double(double value) {
+    BeginValue();
+    // Формат general с точностью 6 совпадает с выводом double в std::ostream
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, DOUBLE_PRECISION);
+    output_.append(buffer, result.ptr);
+    EndValue();
+}
+
+void Writer::String(std::string_view value) {
+    BeginValue();
+    WriteString(value);
+    EndValue();
+}
+
+void Writer::Key(std::string_view key) {
+    if (frames_.empty() || !frames_.back().is_dict || after_key_) {
+        throw std::logic_error("Wrong map key: "s + std::string(key));
+    }
+    Frame& frame = frames_.back();
+    if (!frame.empty && key <= frame.key) {
+        throw std::logic_error("Map keys must be written in ascending order: "s + std::string(key));
+    }
+    if (!frame.empty) {
+        output_ += ",\n"sv;
+    }
+    WriteIndent(indent_);
+    WriteString(key);
+    output_ += ": "sv;
+    frame.key = key;
+    frame.empty = false;
+    after_key_ = true;
+}
+
+void Writer::StartArray() {
+    BeginValue();
+    output_ += "[\n"sv;
+    frames_.push_back({ false, true, {} });
+    indent_ += INDENT_STEP;
+}
+
+void Writer::EndArray() {
+    Close(false);
+}
+
+void Writer::StartDict() {
+    BeginValue();
+    output_ += "{\n"sv;
+    frames_.push_back({ true, true, {} });
+    indent_ += INDENT_STEP;
+}
+
+void Writer::EndDict() {
+    Close(true);
+}
+
+void Writer::EscapedString(std::string_view escaped) {
+    BeginValue();
+    output_ += '"';
+    output_ += escaped;
+    output_ += '"';
+    EndValue();
+}
+
+void Writer::Raw(std::string_view json) {
+    BeginValue();
+    output_ += json;
+    EndValue();
+}
+
+bool Writer::IsComplete() const {
+    return complete_;
+}
+
+void Writer::BeginValue() {
+    if (complete_) {
+        throw std::logic_error("Value is already complete");
+    }
+    if (frames_.empty()) {
+        return;
+    }
+    Frame& frame = frames_.back();
+    if (frame.is_dict) {
+        if (!after_key_) {
+            throw std::logic_error("Map value without a key");
+        }
+        after_key_ = false;
+        return;
+    }
+    if (!frame.empty) {
+        output_ += ",\n"sv;
+    }
+    frame.empty = false;
+    WriteIndent(indent_);
+}
+
+void Writer::EndValue() {
+    if (frames_.empty()) {
+        complete_ = true;
+    }
+}
+
+void Writer::Close(bool is_dict) {
+    if (frames_.empty() || frames_.back().is_dict != is_dict || after_key_) {
+        throw std::logic_error(is_dict ? "Unable to close a Dict"s : "Unable to close an Array"s);
+    }
+    frames_.pop_back();
+    indent_ -= INDENT_STEP;
+    output_ += '\n';
+    WriteIndent(indent_);
+    output_ += is_dict ? '}' : ']';
+    EndValue();
+}
+
+void Writer::WriteIndent(int indent) {
+    output_.append(static_cast<size_t>(indent), ' ');
+}
+
+void Writer::WriteString(std::string_view value) {
+    output_ += '"';
+    AppendEscaped(output_, value);
+    output_ += '"';
+}
+
+} // namespace json
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "json.h"
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+/*
+ * Буфер потока, который дописывает выводимые символы в output, экранируя их
+ * как содержимое строки JSON. Мелкие записи копятся в собственном буфере,
+ * крупные экранируются сразу; sync сбрасывает накопленное
+ */
+class EscapingStreamBuf final : public std::streambuf {
+public:
+    explicit EscapingStreamBuf(std::string& output);
+    ~EscapingStreamBuf() override;
+
+protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* data, std::streamsize size) override;
+    int sync() override;
+
+private:
+    static const size_t BUFFER_SIZE = 1024;
+
+    std::string& output_;
+    char buffer_[BUFFER_SIZE];
+};
+
+/*
+ * Потоковая запись JSON без построения дерева: события дописываются в строку
+ * output в том же виде, что выводит json::Print (отступ 4, числа с точностью 6).
+ * Print упорядочивает ключи словаря, поэтому Key требует ключи по возрастанию
+ * и бросает std::logic_error иначе, как и при нарушении вложенности.
+ * indent — отступ, с которым записываемое значение будет вставлено в объемлющий документ
+ */
+class Writer final : public Handler {
+public:
+    explicit Writer(std::string& output, int indent = 0);
+
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void Key(std::string_view key) override;
+    void StartArray() override;
+    void EndArray() override;
+    void StartDict() override;
+    void EndDict() override;
+
+    // Вставляет значение, записанное другим Writer с отступом текущего уровня
+    void Raw(std::string_view json);
+
+    // Записывает строку, которую write(std::ostream&) выводит в поток: символы
+    // экранируются по мере вывода прямо в output, без промежуточной строки
+    template <typename Write>
+    void StreamString(Write&& write) {
+        BeginValue();
+        output_ += '"';
+        {
+            EscapingStreamBuf buffer(output_);
+            std::ostream out(&buffer);
+            write(out);
+        }
+        output_ += '"';
+        EndValue();
+    }
+
+    // Записывает строку, содержимое которой уже экранировано (например, через EscapingStreamBuf)
+    void EscapedString(std::string_view escaped);
+
+    // Значение записано полностью
+    bool IsComplete() const;
+
+private:
+    struct Frame {
+        bool is_dict;
+        bool empty = true;
+        // Последний записанный ключ словаря
+        std::string key;
+    };
+
+    void BeginValue();
+    void EndValue();
+    void Close(bool is_dict);
+    void WriteIndent(int indent);
+    void WriteString(std::string_view value);
+
+    std::string& output_;
+    int indent_;
+    std::vector<Frame> frames_;
+    bool after_key_ = false;
+    bool complete_ = false;
+};
+
+} // namespace json
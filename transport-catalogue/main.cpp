@@ -1,18 +1,145 @@
+#include "benchmark.h"
+#include "frozen_catalogue.h"
 #include "json_reader.h"
 #include "request_handler.h"
+#include "serialization.h"
 
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <thread>
 
-int main() {
-transport_catalogue::TransportCatalogue db; 
-    JsonReader json_doc(std::cin); 
-     
-    json_doc.FillCatalogue(db); 
-     
-    const auto& stat_requests = json_doc.GetStatRequests(); 
-    const auto& render_settings = json_doc.GetRenderSettings().AsDict(); 
-    const auto& renderer = json_doc.FillRenderSettings(render_settings); 
- 
-    RequestHandler rh(db, renderer); 
-    json_doc.ProcessRequests(stat_requests, rh, std::cout);
+using namespace std::literals;
+
+// Количество пар остановок, на которых make_base сверяет ускоренный поиск маршрута с обычным
+const size_t LANDMARK_CHECK_SAMPLES = 64;
+
+void PrintUsage(std::ostream& stream = std::cerr) {
+    stream << "Usage: transport_catalogue [make_base|process_requests|render_benchmark|builder_benchmark|scan_benchmark|document_benchmark|catalogue_benchmark]\n"sv;
+}
+
+// Без аргументов база и запросы читаются из одного JSON
+void ProcessAll() {
+    transport_catalogue::TransportCatalogue db;
+    JsonReader json_doc(std::cin, db);
+    db.Finalize(std::thread::hardware_concurrency());
+
+    const auto& stat_requests = json_doc.GetStatRequests();
+    const auto& render_settings = json_doc.GetRenderSettings().AsDict();
+    const auto& renderer = json_doc.FillRenderSettings(render_settings);
+
+    std::optional<transport_router::TransportRouter> router;
+    if (json_doc.HasRoutingSettings()) {
+        router.emplace(db, json_doc.FillRoutingSettings(json_doc.GetRoutingSettings().AsDict()));
+        router->BuildLandmarks(std::thread::hardware_concurrency());
+    }
+
+    RequestHandler rh(db, renderer, router ? &*router : nullptr);
+    json_doc.ProcessRequests(stat_requests, rh, std::cout, json_doc.GetThreadCount());
+}
+
+void MakeBase() {
+    transport_catalogue::TransportCatalogue db;
+    JsonReader json_doc(std::cin, db);
+    db.Finalize(std::thread::hardware_concurrency());
+
+    serialization::BaseSettings settings;
+    settings.render_settings = json_doc.FillRenderSettings(json_doc.GetRenderSettings().AsDict()).GetRenderSettings();
+    if (json_doc.HasRoutingSettings()) {
+        settings.routing_settings = json_doc.FillRoutingSettings(json_doc.GetRoutingSettings().AsDict());
+        if (settings.routing_settings->landmark_count > 0) {
+            transport_router::TransportRouter router(db, *settings.routing_settings);
+            router.BuildLandmarks(std::thread::hardware_concurrency());
+            if (!router.CheckLandmarks(LANDMARK_CHECK_SAMPLES)) {
+                throw std::logic_error("Landmark routing disagrees with plain search");
+            }
+            settings.route_landmarks = router.GetLandmarks();
+        }
+    }
+
+    const auto& serialization_settings = json_doc.GetSerializationSettings().AsDict();
+    const std::string file(serialization_settings.at("file").AsString());
+    std::ofstream output(file, std::ios::binary);
+    serialization::SaveBase(db, settings, output);
+
+    // Дополнительно сохраняем неизменяемый снимок для отображения в память вместе с готовой картой
+    if (const auto it = serialization_settings.find("frozen_file"); it != serialization_settings.end()) {
+        const renderer::MapRenderer renderer(settings.render_settings);
+        std::ostringstream map;
+        RequestHandler(db, renderer).RenderMap(map);
+        std::ofstream frozen_output(std::string(it->second.AsString()), std::ios::binary);
+        transport_catalogue::FrozenCatalogue(db, map.str()).Save(frozen_output);
+    }
+}
+
+void ProcessRequests() {
+    transport_catalogue::TransportCatalogue db;
+    LazyJsonReader json_doc(std::cin);
+
+    const auto& serialization_settings = json_doc.GetSerializationSettings().AsDict();
+    if (const auto it = serialization_settings.find("frozen_file"); it != serialization_settings.end()) {
+        const auto frozen = transport_catalogue::FrozenCatalogue::Map(std::string(it->second.AsString()));
+        RequestHandler rh(frozen);
+        json_doc.ProcessRequests(json_doc.GetStatRequests(), rh, std::cout, json_doc.GetThreadCount());
+        return;
+    }
+
+    const std::string file(serialization_settings.at("file").AsString());
+    std::ifstream input(file, std::ios::binary);
+    if (!input) {
+        throw serialization::SerializationError("Unable to open base "s + file);
+    }
+    const auto settings = serialization::LoadBase(input, db);
+    const renderer::MapRenderer renderer(settings.render_settings);
+
+    std::optional<transport_router::TransportRouter> router;
+    if (settings.routing_settings) {
+        router.emplace(db, *settings.routing_settings);
+        if (!settings.route_landmarks.landmarks.empty()) {
+            router->SetLandmarks(settings.route_landmarks);
+        }
+    }
+
+    RequestHandler rh(db, renderer, router ? &*router : nullptr);
+    json_doc.ProcessRequests(json_doc.GetStatRequests(), rh, std::cout, json_doc.GetThreadCount());
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 1) {
+        ProcessAll();
+        return 0;
+    }
+    if (argc != 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    const std::string_view mode(argv[1]);
+    if (mode == "make_base"sv) {
+        MakeBase();
+    }
+    else if (mode == "process_requests"sv) {
+        ProcessRequests();
+    }
+    else if (mode == "render_benchmark"sv) {
+        benchmark::RunRenderBenchmark(std::cin, std::cout);
+    }
+    else if (mode == "builder_benchmark"sv) {
+        benchmark::RunBuilderBenchmark(std::cin, std::cout);
+    }
+    else if (mode == "scan_benchmark"sv) {
+        benchmark::RunScanBenchmark(std::cin, std::cout);
+    }
+    else if (mode == "document_benchmark"sv) {
+        benchmark::RunDocumentBenchmark(std::cin, std::cout);
+    }
+    else if (mode == "catalogue_benchmark"sv) {
+        benchmark::RunCatalogueBenchmark(std::cin, std::cout);
+    }
+    else {
+        PrintUsage();
+        return 1;
+    }
 }
\ No newline at end of file
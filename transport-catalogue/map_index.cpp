@@ -0,0 +1,318 @@
+#include "map_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace renderer {
+
+namespace {
+
+// Наибольший размер сетки по каждой оси
+const uint32_t MAX_GRID_SIDE = 1024;
+// Среднее число остановок на ячейку, на которое рассчитан размер сетки
+const size_t STOPS_PER_CELL = 2;
+const int MAX_TILE_ZOOM = 30;
+// Доля найденных кандидатов (1 / DENSE_QUERY_RATIO), начиная с которой они отбираются отметками
+const size_t DENSE_QUERY_RATIO = 8;
+
+// Пересекает ли отрезок from-to прямоугольник (отсечение Лианга — Барски)
+bool IntersectsSegment(const Viewport& viewport, geo::Coordinates from, geo::Coordinates to) {
+    const double d_lng = to.lng - from.lng;
+    const double d_lat = to.lat - from.lat;
+    double enter = 0.0;
+    double leave = 1.0;
+    const auto clip = [&enter, &leave](double p, double q) {
+        if (p == 0.0) {
+            return q >= 0.0;
+        }
+        const double t = q / p;
+        if (p < 0.0) {
+            enter = std::max(enter, t);
+        }
+        else {
+            leave = std::min(leave, t);
+        }
+        return enter <= leave;
+    };
+    return clip(-d_lng, from.lng - viewport.min.lng)
+        && clip(d_lng, viewport.max.lng - from.lng)
+        && clip(-d_lat, from.lat - viewport.min.lat)
+        && clip(d_lat, viewport.max.lat - from.lat);
+}
+
+// Расстояние от point до отрезка from-to в плоскости (долгота, широта)
+double DistanceToSegment(geo::Coordinates point, geo::Coordinates from, geo::Coordinates to) {
+    const double d_lng = to.lng - from.lng;
+    const double d_lat = to.lat - from.lat;
+    const double length = d_lng * d_lng + d_lat * d_lat;
+    double t = 0.0;
+    if (length > 0.0) {
+        t = std::clamp(((point.lng - from.lng) * d_lng + (point.lat - from.lat) * d_lat) / length, 0.0, 1.0);
+    }
+    return std::hypot(point.lng - from.lng - t * d_lng, point.lat - from.lat - t * d_lat);
+}
+
+} // namespace
+
+std::vector<double> ComputeVertexSignificance(const std::vector<geo::Coordinates>& points) {
+    const double infinity = std::numeric_limits<double>::infinity();
+    std::vector<double> result(points.size(), infinity);
+    if (points.size() < 3) {
+        return result;
+    }
+    // Отрезок [first, last] делится в самой удалённой от хорды вершине. Её значимость —
+    // это расстояние, но не больше значимости вершины, разделившей объемлющий отрезок:
+    // при допуске не меньше той значимости Дуглас — Пекер сюда не доходит
+    struct Range {
+        size_t first;
+        size_t last;
+        double limit;
+    };
+    std::vector<Range> ranges = { { 0, points.size() - 1, infinity } };
+    while (!ranges.empty()) {
+        const Range range = ranges.back();
+        ranges.pop_back();
+        if (range.last - range.first < 2) {
+            continue;
+        }
+        size_t farthest = range.first + 1;
+        double max_distance = -1.0;
+        for (size_t i = range.first + 1; i < range.last; ++i) {
+            const double distance = DistanceToSegment(points[i], points[range.first], points[range.last]);
+            if (distance > max_distance) {
+                max_distance = distance;
+                farthest = i;
+            }
+        }
+        const double significance = std::min(max_distance, range.limit);
+        result[farthest] = significance;
+        ranges.push_back({ range.first, farthest, significance });
+        ranges.push_back({ farthest, range.last, significance });
+    }
+    return result;
+}
+
+bool Viewport::Contains(geo::Coordinates point) const {
+    return point.lat >= min.lat && point.lat <= max.lat && point.lng >= min.lng && point.lng <= max.lng;
+}
+
+Viewport MakeTileViewport(int z, int x, int y) {
+    if (z < 0 || z > MAX_TILE_ZOOM) {
+        throw std::invalid_argument("Tile zoom is out of range");
+    }
+    const double count = std::ldexp(1.0, z);
+    if (x < 0 || y < 0 || x >= count || y >= count) {
+        throw std::invalid_argument("Tile x/y is out of range");
+    }
+    const auto longitude = [count](int x) {
+        return x / count * 360.0 - 180.0;
+    };
+    const auto latitude = [count](int y) {
+        return std::atan(std::sinh(M_PI * (1.0 - 2.0 * y / count))) * 180.0 / M_PI;
+    };
+    // Номера тайлов растут к югу
+    return { { latitude(y + 1), longitude(x) }, { latitude(y), longitude(x + 1) } };
+}
+
+MapIndex::MapIndex(const std::map<std::string_view, BusPtr>& buses) {
+    for (const auto& [_, bus] : buses) {
+        if (bus->stops.empty()) {
+            continue;
+        }
+        const uint32_t id = static_cast<uint32_t>(buses_.size());
+        buses_.push_back(bus);
+        stops_.insert(stops_.end(), bus->stops.begin(), bus->stops.end());
+        for (uint32_t position = 0; position + 1 < bus->stops.size(); ++position) {
+            segments_.push_back({ id, position });
+        }
+        labels_.push_back({ id, bus->stops.front() });
+        if (bus->type == RouteType::Straight && bus->stops.front() != bus->stops.back()) {
+            labels_.push_back({ id, bus->stops.back() });
+        }
+        std::vector<geo::Coordinates> points;
+        points.reserve(bus->stops.size());
+        for (const auto& stop : bus->stops) {
+            points.push_back(stop->coordinates);
+        }
+        significance_offsets_.push_back(static_cast<uint32_t>(significance_.size()));
+        const std::vector<double> significance = ComputeVertexSignificance(points);
+        significance_.insert(significance_.end(), significance.begin(), significance.end());
+    }
+    std::sort(stops_.begin(), stops_.end(), [](StopPtr lhs, StopPtr rhs) {
+        return lhs->name < rhs->name;
+    });
+    stops_.erase(std::unique(stops_.begin(), stops_.end()), stops_.end());
+
+    if (!stops_.empty()) {
+        min_ = max_ = stops_.front()->coordinates;
+        for (const auto& stop : stops_) {
+            min_ = { std::min(min_.lat, stop->coordinates.lat), std::min(min_.lng, stop->coordinates.lng) };
+            max_ = { std::max(max_.lat, stop->coordinates.lat), std::max(max_.lng, stop->coordinates.lng) };
+        }
+    }
+    const double side = std::ceil(std::sqrt(static_cast<double>(stops_.size() / STOPS_PER_CELL)));
+    cols_ = rows_ = std::clamp<uint32_t>(static_cast<uint32_t>(side), 1, MAX_GRID_SIDE);
+    // Вырожденный по оси охват укладывается в одну ячейку любого размера
+    if (max_.lat > min_.lat) {
+        cell_lat_ = (max_.lat - min_.lat) / rows_;
+    }
+    if (max_.lng > min_.lng) {
+        cell_lng_ = (max_.lng - min_.lng) / cols_;
+    }
+
+    const auto point_cell = [this](geo::Coordinates point, auto action) {
+        const CellRange range = GetCells(point, point);
+        action(static_cast<size_t>(range.first_row) * cols_ + range.first_col);
+    };
+    stop_cells_ = BuildCells(stops_.size(), [&](size_t i, auto action) {
+        point_cell(stops_[i]->coordinates, action);
+    });
+    segment_cells_ = BuildCells(segments_.size(), [this](size_t i, auto action) {
+        const Segment& segment = segments_[i];
+        const auto& stops = buses_[segment.bus]->stops;
+        ForEachSegmentCell(stops[segment.position]->coordinates, stops[segment.position + 1]->coordinates, action);
+    });
+    label_cells_ = BuildCells(labels_.size(), [&](size_t i, auto action) {
+        point_cell(labels_[i].stop->coordinates, action);
+    });
+}
+
+const std::vector<BusPtr>& MapIndex::GetBuses() const {
+    return buses_;
+}
+
+MapIndex::Visible MapIndex::Query(const Viewport& viewport) const {
+    Visible result;
+    if (stops_.empty() || viewport.max.lat < min_.lat || viewport.min.lat > max_.lat
+        || viewport.max.lng < min_.lng || viewport.min.lng > max_.lng) {
+        return result;
+    }
+    const CellRange range = GetCells(viewport.min, viewport.max);
+
+    for (const uint32_t i : QueryCells(stop_cells_, stops_.size(), range, [&](uint32_t i) {
+        return viewport.Contains(stops_[i]->coordinates);
+    })) {
+        result.stops.push_back(stops_[i]);
+    }
+    for (const uint32_t i : QueryCells(segment_cells_, segments_.size(), range, [&](uint32_t i) {
+        const auto& stops = buses_[segments_[i].bus]->stops;
+        return IntersectsSegment(viewport, stops[segments_[i].position]->coordinates, stops[segments_[i].position + 1]->coordinates);
+    })) {
+        result.segments.push_back(segments_[i]);
+    }
+    for (const uint32_t i : QueryCells(label_cells_, labels_.size(), range, [&](uint32_t i) {
+        return viewport.Contains(labels_[i].stop->coordinates);
+    })) {
+        result.labels.push_back(labels_[i]);
+    }
+    return result;
+}
+
+double MapIndex::GetSignificance(uint32_t bus, uint32_t position) const {
+    return significance_[significance_offsets_[bus] + position];
+}
+
+MapIndex::CellRange MapIndex::GetCells(geo::Coordinates min, geo::Coordinates max) const {
+    const auto col = [this](double lng) {
+        const double cell = std::floor((lng - min_.lng) / cell_lng_);
+        return static_cast<uint32_t>(std::clamp(cell, 0.0, cols_ - 1.0));
+    };
+    const auto row = [this](double lat) {
+        const double cell = std::floor((lat - min_.lat) / cell_lat_);
+        return static_cast<uint32_t>(std::clamp(cell, 0.0, rows_ - 1.0));
+    };
+    return { col(min.lng), col(max.lng), row(min.lat), row(max.lat) };
+}
+
+template <typename Action>
+void MapIndex::ForEachSegmentCell(geo::Coordinates from, geo::Coordinates to, Action action) const {
+    // Отрезок проходится по столбцам сетки: в каждом столбце он занимает строки
+    // между своими широтами на границах столбца. Так перечисляются ровно те ячейки,
+    // которых касается отрезок, а не весь охватывающий его прямоугольник
+    if (from.lng > to.lng) {
+        std::swap(from, to);
+    }
+    const CellRange range = GetCells({ from.lat, from.lng }, { from.lat, to.lng });
+    const double slope = to.lng > from.lng ? (to.lat - from.lat) / (to.lng - from.lng) : 0.0;
+    for (uint32_t col = range.first_col; col <= range.last_col; ++col) {
+        const double left = std::max(from.lng, min_.lng + col * cell_lng_);
+        const double right = std::min(to.lng, min_.lng + (col + 1) * cell_lng_);
+        double lat_left = from.lat + (left - from.lng) * slope;
+        double lat_right = from.lat + (right - from.lng) * slope;
+        if (col == range.first_col) {
+            lat_left = from.lat;
+        }
+        if (col == range.last_col) {
+            lat_right = to.lat;
+        }
+        // Запас на погрешность округления у границ строк: лишняя ячейка безвредна,
+        // её отсеет точная проверка при запросе
+        const double margin = cell_lat_ * 1e-9;
+        const CellRange rows = GetCells({ std::min(lat_left, lat_right) - margin, left }, { std::max(lat_left, lat_right) + margin, left });
+        for (uint32_t row = rows.first_row; row <= rows.last_row; ++row) {
+            action(static_cast<size_t>(row) * cols_ + col);
+        }
+    }
+}
+
+template <typename ForEachCell>
+MapIndex::Cells MapIndex::BuildCells(size_t count, ForEachCell for_each_cell) const {
+    // Первый проход считает элементы в ячейках, второй раскладывает их
+    Cells cells;
+    cells.offsets.assign(static_cast<size_t>(cols_) * rows_ + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        for_each_cell(i, [&cells](size_t cell) {
+            ++cells.offsets[cell + 1];
+        });
+    }
+    for (size_t cell = 1; cell < cells.offsets.size(); ++cell) {
+        cells.offsets[cell] += cells.offsets[cell - 1];
+    }
+    cells.items.resize(cells.offsets.back());
+    std::vector<uint32_t> next(cells.offsets.begin(), cells.offsets.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        for_each_cell(i, [&cells, &next, i](size_t cell) {
+            cells.items[next[cell]++] = static_cast<uint32_t>(i);
+        });
+    }
+    return cells;
+}
+
+template <typename Accept>
+std::vector<uint32_t> MapIndex::QueryCells(const Cells& cells, size_t count, const CellRange& range, Accept accept) const {
+    std::vector<uint32_t> result;
+    for (uint32_t row = range.first_row; row <= range.last_row; ++row) {
+        const size_t first_cell = static_cast<size_t>(row) * cols_ + range.first_col;
+        const size_t last_cell = static_cast<size_t>(row) * cols_ + range.last_col;
+        for (uint32_t k = cells.offsets[first_cell]; k < cells.offsets[last_cell + 1]; ++k) {
+            result.push_back(cells.items[k]);
+        }
+    }
+    // Протяжённый элемент лежит в нескольких ячейках; номера элементов задают порядок вывода.
+    // Если кандидатов много, повторы дешевле отсеять отметками, чем сортировкой
+    if (result.size() * DENSE_QUERY_RATIO > count) {
+        std::vector<char> found(count);
+        for (const uint32_t i : result) {
+            found[i] = true;
+        }
+        result.clear();
+        for (uint32_t i = 0; i < count; ++i) {
+            if (found[i]) {
+                result.push_back(i);
+            }
+        }
+    }
+    else {
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+    result.erase(std::remove_if(result.begin(), result.end(), [&accept](uint32_t i) {
+        return !accept(i);
+    }), result.end());
+    return result;
+}
+
+} // namespace renderer
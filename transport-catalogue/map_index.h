@@ -0,0 +1,119 @@
+#pragma once
+
+#include "domain.h"
+#include "geo.h"
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <vector>
+
+namespace renderer {
+
+using namespace transport_catalogue;
+using namespace domain;
+
+// Прямоугольная область карты в географических координатах
+struct Viewport {
+    // Наименьшие широта и долгота
+    geo::Coordinates min;
+    // Наибольшие широта и долгота
+    geo::Coordinates max;
+
+    bool Contains(geo::Coordinates point) const;
+};
+
+// Область тайла z/x/y в схеме тайлов веб-карт (проекция Web Mercator)
+Viewport MakeTileViewport(int z, int x, int y);
+
+/*
+ * Значимость вершин ломаной для упрощения Дугласа — Пекера в плоскости (долгота, широта):
+ * вершина остаётся при допуске tolerance тогда и только тогда, когда её значимость больше
+ * tolerance. Так один проход заменяет упрощения для всех масштабов сразу.
+ * Концы ломаной имеют бесконечную значимость
+ */
+std::vector<double> ComputeVertexSignificance(const std::vector<geo::Coordinates>& points);
+
+/*
+ * Пространственный индекс карты: равномерная сетка над остановками маршрутов,
+ * перегонами между соседними остановками и точками подписей маршрутов.
+ * Строится один раз по справочнику; запрос области просматривает только
+ * накрытые ею ячейки, поэтому его стоимость зависит от видимой части карты.
+ * Порядок маршрутов и остановок тот же, что у полной карты MapRenderer
+ */
+class MapIndex {
+public:
+    // Перегон от bus->stops[position] до bus->stops[position + 1]
+    struct Segment {
+        uint32_t bus;
+        uint32_t position;
+    };
+
+    // Точка подписи маршрута: его первая или конечная остановка
+    struct Label {
+        uint32_t bus;
+        StopPtr stop;
+    };
+
+    struct Visible {
+        // Остановки в порядке имён
+        std::vector<StopPtr> stops;
+        // Перегоны и подписи в порядке маршрутов, перегоны маршрута — по порядку
+        std::vector<Segment> segments;
+        std::vector<Label> labels;
+    };
+
+    explicit MapIndex(const std::map<std::string_view, BusPtr>& buses);
+
+    // Маршруты с остановками в порядке имён; номер маршрута — индекс в этом массиве
+    const std::vector<BusPtr>& GetBuses() const;
+
+    // Остановки, перегоны и подписи, пересекающие область
+    Visible Query(const Viewport& viewport) const;
+
+    // Значимость остановки bus->stops[position] в ломаной прямого хода маршрута
+    double GetSignificance(uint32_t bus, uint32_t position) const;
+
+private:
+    // Элементы ячеек в формате CSR: ячейка cell занимает items[offsets[cell], offsets[cell + 1])
+    struct Cells {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> items;
+    };
+
+    struct CellRange {
+        uint32_t first_col;
+        uint32_t last_col;
+        uint32_t first_row;
+        uint32_t last_row;
+    };
+
+    CellRange GetCells(geo::Coordinates min, geo::Coordinates max) const;
+    template <typename Action>
+    void ForEachSegmentCell(geo::Coordinates from, geo::Coordinates to, Action action) const;
+    template <typename ForEachCell>
+    Cells BuildCells(size_t count, ForEachCell for_each_cell) const;
+    template <typename Accept>
+    std::vector<uint32_t> QueryCells(const Cells& cells, size_t count, const CellRange& range, Accept accept) const;
+
+    std::vector<BusPtr> buses_;
+    std::vector<StopPtr> stops_;
+    std::vector<Segment> segments_;
+    std::vector<Label> labels_;
+    // Значимости остановок маршрута bus лежат с позиции significance_offsets_[bus]
+    std::vector<double> significance_;
+    std::vector<uint32_t> significance_offsets_;
+
+    geo::Coordinates min_ = { 0.0, 0.0 };
+    geo::Coordinates max_ = { 0.0, 0.0 };
+    uint32_t cols_ = 1;
+    uint32_t rows_ = 1;
+    double cell_lat_ = 1.0;
+    double cell_lng_ = 1.0;
+
+    Cells stop_cells_;
+    Cells segment_cells_;
+    Cells label_cells_;
+};
+
+} // namespace renderer
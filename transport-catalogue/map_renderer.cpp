@@ -1,11 +1,78 @@
 #include "map_renderer.h"
 
+#include <atomic>
+#include <thread>
+
 namespace renderer {
 
 bool IsZero(double value) {
     return std::abs(value) < EPSILON;
 }
 
+namespace {
+
+// Фрагментов каждого слоя на поток: запас на неравную стоимость фрагментов
+const size_t CHUNKS_PER_THREAD = 4;
+// Меньшие фрагменты не окупают отдельный буфер
+const size_t MIN_CHUNK_SIZE = 256;
+// Длина закрывающего тега </svg>
+const size_t SVG_END_SIZE = 6;
+
+// Допуск упрощения в градусах для проекции sp; 0, если упрощать не нужно
+double SimplifyThreshold(double tolerance, const SphereProjector& sp) {
+    return tolerance > 0.0 && sp.GetZoom() > 0.0 ? tolerance / sp.GetZoom() : 0.0;
+}
+
+} // namespace
+
+MapRenderer::MapRenderer(const RenderSettings& render_settings)
+    : render_settings_(render_settings) {
+    const auto& palette = render_settings_.color_palette;
+    
+    svg::PathStyle underlayer;
+    underlayer.SetFillColor(render_settings_.underlayer_color);
+    underlayer.SetStrokeColor(render_settings_.underlayer_color);
+    underlayer.SetStrokeWidth(render_settings_.underlayer_width);
+    underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+    underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+    
+    for (size_t i = 0; i < palette.size(); ++i) {
+        svg::PathStyle line;
+        line.SetStrokeColor(palette[i]);
+        line.SetFillColor("none");
+        line.SetStrokeWidth(render_settings_.line_width);
+        line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+        line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+        const StyleId id = styles_.AddPath(line);
+        if (i == 0) {
+            route_line_style_ = id;
+        }
+    }
+    
+    const svg::Point bus_offset = render_settings_.bus_label_offset;
+    const uint32_t bus_font_size = render_settings_.bus_label_font_size;
+    bus_label_underlayer_style_ = styles_.AddText(underlayer, bus_offset, bus_font_size, "Verdana", "bold");
+    for (size_t i = 0; i < palette.size(); ++i) {
+        svg::PathStyle text;
+        text.SetFillColor(palette[i]);
+        const StyleId id = styles_.AddText(text, bus_offset, bus_font_size, "Verdana", "bold");
+        if (i == 0) {
+            bus_label_style_ = id;
+        }
+    }
+    
+    svg::PathStyle symbol;
+    symbol.SetFillColor("white");
+    stop_symbol_style_ = styles_.AddPath(symbol);
+    
+    const svg::Point stop_offset = render_settings_.stop_label_offset;
+    const uint32_t stop_font_size = render_settings_.stop_label_font_size;
+    stop_label_underlayer_style_ = styles_.AddText(underlayer, stop_offset, stop_font_size, "Verdana", "");
+    svg::PathStyle label;
+    label.SetFillColor("black");
+    stop_label_style_ = styles_.AddText(label, stop_offset, stop_font_size, "Verdana", "");
+}
+
 std::vector<svg::Polyline> MapRenderer::RenderRouteLines(const std::map<std::string_view, BusPtr>& buses, const SphereProjector& sp) const {
     std::vector<svg::Polyline> result;
     size_t color_num = 0;
@@ -157,4 +224,308 @@ svg::Document MapRenderer::RenderSVG(const std::map<std::string_view, BusPtr>& b
     return result;
 }
 
+void MapRenderer::RenderSVG(const std::map<std::string_view, BusPtr>& buses, std::string& output) const {
+    RenderSVG(buses, output, 1);
+}
+
+void MapRenderer::RenderSVG(const std::map<std::string_view, BusPtr>& buses, std::string& output,
+                            size_t threads_count, RenderTimings* timings) const {
+    RenderSVG(buses, render_settings_.simplify_tolerance, output, threads_count, timings);
+}
+
+void MapRenderer::RenderSVG(const std::map<std::string_view, BusPtr>& buses, double simplify_tolerance, std::string& output,
+                            size_t threads_count, RenderTimings* timings) const {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    
+    const MapLayout layout = PrepareMap(buses);
+    const auto& routes = layout.routes;
+    const auto& all_stops = layout.all_stops;
+    const SphereProjector& sp = layout.sp;
+    
+    /*
+     * Слои карты независимы: каждый проходит по своим элементам с общей проекцией.
+     * Слой делится на фрагменты по диапазонам элементов, фрагменты рисуются
+     * в собственные буферы и склеиваются в порядке слоёв, поэтому результат
+     * не зависит от числа потоков. В один поток каждый слой — один фрагмент
+     * и пишется прямо в output
+     */
+    enum Layer { ROUTE_LINES, BUS_LABELS, STOP_SYMBOLS, STOP_LABELS, LAYER_COUNT };
+    struct Chunk {
+        Layer layer;
+        size_t first;
+        size_t last;
+        std::string output;
+        std::chrono::nanoseconds duration{ 0 };
+    };
+    threads_count = std::max<size_t>(1, threads_count);
+    std::vector<Chunk> chunks;
+    for (const Layer layer : { ROUTE_LINES, BUS_LABELS, STOP_SYMBOLS, STOP_LABELS }) {
+        const size_t count = layer == ROUTE_LINES || layer == BUS_LABELS ? routes.size() : all_stops.size();
+        const size_t chunk_size = threads_count == 1 ? std::max<size_t>(count, 1)
+            : std::max((count + threads_count * CHUNKS_PER_THREAD - 1) / (threads_count * CHUNKS_PER_THREAD), MIN_CHUNK_SIZE);
+        for (size_t first = 0; first < count || first == 0; first += chunk_size) {
+            chunks.push_back({ layer, first, std::min(first + chunk_size, count), {} });
+        }
+    }
+    
+    const double simplify_threshold = SimplifyThreshold(simplify_tolerance, sp);
+    const auto render_chunk = [&](Chunk& chunk, std::string& chunk_output) {
+        const auto chunk_start = Clock::now();
+        svg::BufferWriter writer(chunk_output, styles_, render_settings_.compact_output);
+        switch (chunk.layer) {
+        case ROUTE_LINES:
+            WriteRouteLines(routes, chunk.first, chunk.last, sp, simplify_threshold, writer);
+            break;
+        case BUS_LABELS:
+            WriteBusLabels(routes, chunk.first, chunk.last, sp, writer);
+            break;
+        case STOP_SYMBOLS:
+            WriteStopSymbols(all_stops, chunk.first, chunk.last, sp, writer);
+            break;
+        default:
+            WriteStopLabels(all_stops, chunk.first, chunk.last, sp, writer);
+            break;
+        }
+        chunk.duration = Clock::now() - chunk_start;
+    };
+    
+    const auto prepared = Clock::now();
+    svg::BufferWriter(output, styles_, render_settings_.compact_output).BeginDocument();
+    if (threads_count == 1) {
+        for (auto& chunk : chunks) {
+            render_chunk(chunk, output);
+        }
+    }
+    else {
+        std::atomic<size_t> next_chunk = 0;
+        const auto worker = [&]() {
+            for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+                render_chunk(chunks[i], chunks[i].output);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < std::min(threads_count, chunks.size()); ++i) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : workers) {
+            thread.join();
+        }
+    }
+    const auto rendered = Clock::now();
+    size_t size = output.size() + SVG_END_SIZE;
+    for (const auto& chunk : chunks) {
+        size += chunk.output.size();
+    }
+    output.reserve(size);
+    for (const auto& chunk : chunks) {
+        output += chunk.output;
+    }
+    svg::BufferWriter(output, styles_, render_settings_.compact_output).EndDocument();
+    
+    if (timings) {
+        *timings = {};
+        timings->prepare = prepared - start;
+        std::chrono::nanoseconds* layers[LAYER_COUNT] = {
+            &timings->route_lines, &timings->bus_labels, &timings->stop_symbols, &timings->stop_labels
+        };
+        for (const auto& chunk : chunks) {
+            *layers[chunk.layer] += chunk.duration;
+        }
+        timings->concatenation = Clock::now() - rendered;
+        timings->total = Clock::now() - start;
+    }
+}
+
+void MapRenderer::RenderSVG(const std::map<std::string_view, BusPtr>& buses, std::ostream& out) const {
+    RenderSVG(buses, render_settings_.simplify_tolerance, out);
+}
+
+void MapRenderer::RenderSVG(const std::map<std::string_view, BusPtr>& buses, double simplify_tolerance, std::ostream& out) const {
+    const MapLayout layout = PrepareMap(buses);
+    const auto& routes = layout.routes;
+    const auto& all_stops = layout.all_stops;
+    const SphereProjector& sp = layout.sp;
+    svg::BufferWriter writer(out, styles_, render_settings_.compact_output);
+    writer.BeginDocument();
+    WriteRouteLines(routes, 0, routes.size(), sp, SimplifyThreshold(simplify_tolerance, sp), writer);
+    WriteBusLabels(routes, 0, routes.size(), sp, writer);
+    WriteStopSymbols(all_stops, 0, all_stops.size(), sp, writer);
+    WriteStopLabels(all_stops, 0, all_stops.size(), sp, writer);
+    writer.EndDocument();
+}
+
+MapRenderer::MapLayout MapRenderer::PrepareMap(const std::map<std::string_view, BusPtr>& buses) const {
+    std::vector<BusPtr> routes;
+    std::vector<geo::Coordinates> route_stops_coord;
+    // Остановки маршрутов, упорядоченные по имени без повторов, как в RenderSVG
+    std::vector<StopPtr> all_stops;
+    for (const auto& [_, bus] : buses) {
+        if (!bus->stops.empty()) {
+            routes.push_back(bus);
+        }
+        for (const auto& stop : bus->stops) {
+            route_stops_coord.push_back(stop->coordinates);
+            all_stops.push_back(stop);
+        }
+    }
+    std::sort(all_stops.begin(), all_stops.end(), [](StopPtr lhs, StopPtr rhs) {
+        return lhs->name < rhs->name;
+    });
+    all_stops.erase(std::unique(all_stops.begin(), all_stops.end()), all_stops.end());
+    const SphereProjector sp(route_stops_coord.begin(), route_stops_coord.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
+    return { std::move(routes), std::move(all_stops), sp };
+}
+
+void MapRenderer::RenderSVG(const MapIndex& index, const Viewport& viewport, std::string& output) const {
+    RenderSVG(index, viewport, render_settings_.simplify_tolerance, output);
+}
+
+void MapRenderer::RenderSVG(const MapIndex& index, const Viewport& viewport, double simplify_tolerance, std::string& output) const {
+    svg::BufferWriter writer(output, styles_, render_settings_.compact_output);
+    WriteViewport(index, viewport, simplify_tolerance, writer);
+}
+
+void MapRenderer::RenderSVG(const MapIndex& index, const Viewport& viewport, double simplify_tolerance, std::ostream& out) const {
+    svg::BufferWriter writer(out, styles_, render_settings_.compact_output);
+    WriteViewport(index, viewport, simplify_tolerance, writer);
+}
+
+void MapRenderer::WriteViewport(const MapIndex& index, const Viewport& viewport, double simplify_tolerance,
+                                svg::BufferWriter& writer) const {
+    const MapIndex::Visible visible = index.Query(viewport);
+    const std::vector<geo::Coordinates> corners = { viewport.min, viewport.max };
+    SphereProjector sp(corners.begin(), corners.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
+    const auto& buses = index.GetBuses();
+    const size_t palette_size = render_settings_.color_palette.size();
+    const auto color_of = [palette_size](uint32_t bus) {
+        return static_cast<StyleId>(palette_size == 0 ? 0 : bus % palette_size);
+    };
+    
+    const double simplify_threshold = SimplifyThreshold(simplify_tolerance, sp);
+    
+    writer.BeginDocument();
+    
+    // Подряд идущие видимые перегоны маршрута выводятся одной ломаной. При упрощении
+    // концы ломаной остаются всегда, а внутренние остановки — по значимости в маршруте
+    const auto& segments = visible.segments;
+    for (size_t i = 0; i < segments.size();) {
+        const uint32_t bus = segments[i].bus;
+        const auto& stops = buses[bus]->stops;
+        writer.BeginPolyline();
+        writer.AddPoint(sp(stops[segments[i].position]->coordinates));
+        size_t j = i;
+        for (; j < segments.size() && segments[j].bus == bus && segments[j].position == segments[i].position + (j - i); ++j) {
+            const uint32_t position = segments[j].position + 1;
+            const bool last = j + 1 == segments.size() || segments[j + 1].bus != bus || segments[j + 1].position != position;
+            if (last || simplify_threshold <= 0.0 || index.GetSignificance(bus, position) > simplify_threshold) {
+                writer.AddPoint(sp(stops[position]->coordinates));
+            }
+        }
+        writer.EndPolyline(route_line_style_ + color_of(bus));
+        i = j;
+    }
+    
+    for (const auto& label : visible.labels) {
+        const svg::Point position = sp(label.stop->coordinates);
+        const std::string_view name = buses[label.bus]->name;
+        writer.Text(position, name, bus_label_underlayer_style_);
+        writer.Text(position, name, bus_label_style_ + color_of(label.bus));
+    }
+    
+    for (const auto& stop : visible.stops) {
+        writer.Circle(sp(stop->coordinates), render_settings_.stop_radius, stop_symbol_style_);
+    }
+    for (const auto& stop : visible.stops) {
+        const svg::Point position = sp(stop->coordinates);
+        writer.Text(position, stop->name, stop_label_underlayer_style_);
+        writer.Text(position, stop->name, stop_label_style_);
+    }
+    
+    writer.EndDocument();
+}
+
+void MapRenderer::WriteRouteLines(const std::vector<BusPtr>& routes, size_t first, size_t last, const SphereProjector& sp,
+                                  double simplify_threshold, svg::BufferWriter& writer) const {
+    const size_t palette_size = render_settings_.color_palette.size();
+    std::vector<geo::Coordinates> route_points;
+    std::vector<geo::Coordinates> kept;
+    for (size_t i = first; i < last; ++i) {
+        const BusPtr bus = routes[i];
+        writer.BeginPolyline();
+        if (simplify_threshold > 0.0) {
+            // Обратный ход прямого маршрута проходит те же точки, поэтому упрощается
+            // только прямой, а обратный повторяет оставшиеся остановки в обратном порядке
+            route_points.clear();
+            for (const auto& stop : bus->stops) {
+                route_points.push_back(stop->coordinates);
+            }
+            const std::vector<double> significance = ComputeVertexSignificance(route_points);
+            kept.clear();
+            for (size_t j = 0; j < route_points.size(); ++j) {
+                if (significance[j] > simplify_threshold) {
+                    kept.push_back(route_points[j]);
+                }
+            }
+            for (const auto& point : kept) {
+                writer.AddPoint(sp(point));
+            }
+            if (bus->type == RouteType::Straight) {
+                for (auto it = std::next(kept.rbegin()); it != kept.rend(); ++it) {
+                    writer.AddPoint(sp(*it));
+                }
+            }
+        }
+        else {
+            for (const auto& stop : bus->stops) {
+                writer.AddPoint(sp(stop->coordinates));
+            }
+            if (bus->type == RouteType::Straight) {
+                for (auto it = std::next(bus->stops.rbegin()); it != bus->stops.rend(); ++it) {
+                    writer.AddPoint(sp((*it)->coordinates));
+                }
+            }
+        }
+        writer.EndPolyline(route_line_style_ + static_cast<StyleId>(palette_size == 0 ? 0 : i % palette_size));
+    }
+}
+
+void MapRenderer::WriteBusLabels(const std::vector<BusPtr>& routes, size_t first, size_t last, const SphereProjector& sp,
+                                 svg::BufferWriter& writer) const {
+    const size_t palette_size = render_settings_.color_palette.size();
+    for (size_t i = first; i < last; ++i) {
+        const BusPtr bus = routes[i];
+        const StyleId text_style = bus_label_style_ + static_cast<StyleId>(palette_size == 0 ? 0 : i % palette_size);
+        const svg::Point position = sp(bus->stops.front()->coordinates);
+        writer.Text(position, bus->name, bus_label_underlayer_style_);
+        writer.Text(position, bus->name, text_style);
+        if (bus->type == RouteType::Straight && bus->stops.front() != bus->stops.back()) {
+            const svg::Point last_position = sp(bus->stops.back()->coordinates);
+            writer.Text(last_position, bus->name, bus_label_underlayer_style_);
+            writer.Text(last_position, bus->name, text_style);
+        }
+    }
+}
+
+void MapRenderer::WriteStopSymbols(const std::vector<StopPtr>& stops, size_t first, size_t last, const SphereProjector& sp,
+                                   svg::BufferWriter& writer) const {
+    for (size_t i = first; i < last; ++i) {
+        writer.Circle(sp(stops[i]->coordinates), render_settings_.stop_radius, stop_symbol_style_);
+    }
+}
+
+void MapRenderer::WriteStopLabels(const std::vector<StopPtr>& stops, size_t first, size_t last, const SphereProjector& sp,
+                                  svg::BufferWriter& writer) const {
+    for (size_t i = first; i < last; ++i) {
+        const svg::Point position = sp(stops[i]->coordinates);
+        writer.Text(position, stops[i]->name, stop_label_underlayer_style_);
+        writer.Text(position, stops[i]->name, stop_label_style_);
+    }
+}
+
+const RenderSettings& MapRenderer::GetRenderSettings() const {
+    return render_settings_;
+}
+
 } // namespace renderer
\ No newline at end of file
@@ -4,8 +4,10 @@
 #include "domain.h" 
 #include "geo.h" 
 #include "json.h" 
+#include "map_index.h" 
  
 #include <algorithm>
+#include <chrono>
 
 namespace renderer {
 
@@ -72,6 +74,11 @@ public:
         };
     }
     
+    // Число пикселей на градус по обеим осям
+    double GetZoom() const {
+        return zoom_coeff_;
+    }
+    
 private:
     double padding_;
     double min_lon_ = 0;
@@ -92,16 +99,32 @@ struct RenderSettings {
     svg::Color underlayer_color = { svg::NoneColor };
     double underlayer_width = 0.0;
     std::vector<svg::Color> color_palette {};
+    // Допуск упрощения линий маршрутов в пикселях; 0 — без упрощения
+    double simplify_tolerance = 0.0;
+    // Компактный вывод карты; без него карта совпадает с выводом svg::Document
+    std::optional<svg::CompactOptions> compact_output;
 };
     
 using namespace transport_catalogue; 
 using namespace domain;
 
+// Время этапов отрисовки полной карты
+struct RenderTimings {
+    // Сбор остановок и построение проекции
+    std::chrono::nanoseconds prepare{ 0 };
+    // Время слоёв, сложенное по всем их частям и потокам
+    std::chrono::nanoseconds route_lines{ 0 };
+    std::chrono::nanoseconds bus_labels{ 0 };
+    std::chrono::nanoseconds stop_symbols{ 0 };
+    std::chrono::nanoseconds stop_labels{ 0 };
+    // Склейка частей в итоговый документ
+    std::chrono::nanoseconds concatenation{ 0 };
+    std::chrono::nanoseconds total{ 0 };
+};
+
 class MapRenderer {
 public:
-    MapRenderer(const RenderSettings& render_settings)
-        : render_settings_(render_settings) {
-    }
+    MapRenderer(const RenderSettings& render_settings);
     
     std::vector<svg::Polyline> RenderRouteLines(const std::map<std::string_view, BusPtr>& buses, const SphereProjector& sp) const; 
     std::vector<svg::Text> RenderBusLabel(const std::map<std::string_view, BusPtr>& buses, const SphereProjector& sp) const; 
@@ -109,9 +132,67 @@ public:
     std::vector<svg::Text> RenderStopsLabels(const std::map<std::string_view, StopPtr>& stops, const SphereProjector& sp) const; 
      
     svg::Document RenderSVG(const std::map<std::string_view, BusPtr>& buses) const;
+    // Дописывает в output ту же карту, что выводит RenderSVG(buses).Render, но напрямую
+    // через svg::BufferWriter: без объектов svg::Document и выделений памяти на примитив
+    // Если задан simplify_tolerance, линии маршрутов упрощаются: остановки, отклоняющиеся
+    // от упрощённой линии меньше чем на допуск в пикселях, в ломаную не попадают
+    void RenderSVG(const std::map<std::string_view, BusPtr>& buses, std::string& output) const;
+    // То же в threads_count потоков: слои и их части рисуются параллельно в отдельные
+    // буферы и склеиваются по порядку, поэтому вывод побайтно совпадает с однопоточным.
+    // Если передан timings, в него записывается время этапов отрисовки
+    void RenderSVG(const std::map<std::string_view, BusPtr>& buses, std::string& output,
+                   size_t threads_count, RenderTimings* timings = nullptr) const;
+    // То же с допуском упрощения линий simplify_tolerance вместо допуска из настроек
+    void RenderSVG(const std::map<std::string_view, BusPtr>& buses, double simplify_tolerance, std::string& output,
+                   size_t threads_count = 1, RenderTimings* timings = nullptr) const;
+    // Выводит ту же карту в поток через небольшой буфер, без строки со всей картой:
+    // например, сразу в json::EscapingStreamBuf ответа
+    void RenderSVG(const std::map<std::string_view, BusPtr>& buses, std::ostream& out) const;
+    void RenderSVG(const std::map<std::string_view, BusPtr>& buses, double simplify_tolerance, std::ostream& out) const;
+    // Дописывает в output часть карты внутри viewport, вписанную в размеры холста:
+    // видимые участки линий маршрутов, подписи и остановки. Цвета маршрутов те же,
+    // что на полной карте. Элементы выбираются через индекс, без обхода всего справочника.
+    // Линии упрощаются с допуском simplify_tolerance пикселей по значимостям из индекса
+    void RenderSVG(const MapIndex& index, const Viewport& viewport, std::string& output) const;
+    void RenderSVG(const MapIndex& index, const Viewport& viewport, double simplify_tolerance, std::string& output) const;
+    void RenderSVG(const MapIndex& index, const Viewport& viewport, double simplify_tolerance, std::ostream& out) const;
+    
+    const RenderSettings& GetRenderSettings() const;
     
 private:
+    using StyleId = svg::StyleTable::StyleId;
+
+    // Маршруты с остановками (номер в массиве задаёт цвет), их остановки
+    // по имени без повторов и проекция полной карты
+    struct MapLayout {
+        std::vector<BusPtr> routes;
+        std::vector<StopPtr> all_stops;
+        SphereProjector sp;
+    };
+    MapLayout PrepareMap(const std::map<std::string_view, BusPtr>& buses) const;
+    void WriteViewport(const MapIndex& index, const Viewport& viewport, double simplify_tolerance,
+                       svg::BufferWriter& writer) const;
+
+    // Слои полной карты по диапазону [first, last) маршрутов или остановок
+    void WriteRouteLines(const std::vector<BusPtr>& routes, size_t first, size_t last, const SphereProjector& sp,
+                         double simplify_threshold, svg::BufferWriter& writer) const;
+    void WriteBusLabels(const std::vector<BusPtr>& routes, size_t first, size_t last, const SphereProjector& sp,
+                        svg::BufferWriter& writer) const;
+    void WriteStopSymbols(const std::vector<StopPtr>& stops, size_t first, size_t last, const SphereProjector& sp,
+                          svg::BufferWriter& writer) const;
+    void WriteStopLabels(const std::vector<StopPtr>& stops, size_t first, size_t last, const SphereProjector& sp,
+                         svg::BufferWriter& writer) const;
+
     const RenderSettings render_settings_;
+    // Стили карты строятся один раз по настройкам. Стили линий и названий
+    // маршрутов идут подряд, по одному на цвет палитры
+    svg::StyleTable styles_;
+    StyleId route_line_style_ = 0;
+    StyleId bus_label_style_ = 0;
+    StyleId bus_label_underlayer_style_ = 0;
+    StyleId stop_symbol_style_ = 0;
+    StyleId stop_label_style_ = 0;
+    StyleId stop_label_underlayer_style_ = 0;
 };
 
 } // namespace renderer
\ No newline at end of file
@@ -1,21 +1,106 @@
 #include "request_handler.h"
+#include "json_writer.h"
 
 std::optional<BusStat> RequestHandler::GetBusStat(const std::string_view& bus_name) const {
-    return db_.GetRouteStatistics(bus_name);
+    if (frozen_) {
+        return frozen_->GetRouteStatistics(bus_name);
+    }
+    return db_->GetRouteStatistics(bus_name);
 }
 
-const std::set<std::string_view> RequestHandler::GetBusesByStop(const std::string_view& stop_name) const { 
-    return db_.GetStop(stop_name)->buses_by_stop; 
+std::vector<std::string_view> RequestHandler::GetBusesByStop(const std::string_view& stop_name) const { 
+    if (frozen_) { 
+        return frozen_->GetBusesByStop(stop_name); 
+    } 
+    const auto& buses = db_->GetStop(stop_name)->buses_by_stop; 
+    return { buses.begin(), buses.end() }; 
+}
+
+std::optional<transport_router::RouteInfo> RequestHandler::BuildRoute(const std::string_view& from, const std::string_view& to) const { 
+    if (!router_) { 
+        throw std::logic_error("Routing is not configured"); 
+    } 
+    return router_->FindRoute(from, to); 
 }
 
 bool RequestHandler::IsBusNumber(const std::string_view& bus_name) const { 
-    return db_.GetRoute(bus_name); 
+    if (frozen_) { 
+        return frozen_->FindRoute(bus_name).has_value(); 
+    } 
+    return db_->GetRoute(bus_name); 
 } 
  
 bool RequestHandler::IsStopName(const std::string_view& stop_name) const { 
-    return db_.GetStop(stop_name); 
+    if (frozen_) { 
+        return frozen_->FindStop(stop_name).has_value(); 
+    } 
+    return db_->GetStop(stop_name); 
 }
 
 svg::Document RequestHandler::RenderMap() const { 
-    return renderer_.RenderSVG(db_.SortBuses()); 
-}
\ No newline at end of file
+    if (!db_) { 
+        throw std::logic_error("Map rendering requires a transport catalogue"); 
+    } 
+    return renderer_->RenderSVG(db_->SortBuses()); 
+}
+
+void RequestHandler::RenderMap(std::ostream& out) const { 
+    if (frozen_) { 
+        out << frozen_->GetRenderedMap(); 
+        return; 
+    } 
+    if (!db_) { 
+        throw std::logic_error("Map rendering requires a transport catalogue"); 
+    } 
+    renderer_->RenderSVG(db_->SortBuses(), out); 
+}
+
+std::shared_ptr<const std::string> RequestHandler::GetMapJsonString(std::optional<double> simplify_tolerance) const { 
+    if (simplify_tolerance && (frozen_ || *simplify_tolerance != renderer_->GetRenderSettings().simplify_tolerance)) { 
+        if (!db_) { 
+            throw std::logic_error("Map rendering requires a transport catalogue"); 
+        } 
+        auto json = std::make_shared<std::string>(); 
+        { 
+            json::EscapingStreamBuf buffer(*json); 
+            std::ostream out(&buffer); 
+            renderer_->RenderSVG(db_->SortBuses(), *simplify_tolerance, out); 
+        } 
+        return json; 
+    } 
+    // У снимка карта неизменна, у справочника — до следующего изменения 
+    const uint64_t version = frozen_ ? 0 : db_->GetVersion(); 
+    std::lock_guard guard(map_mutex_); 
+    if (!rendered_map_.json || rendered_map_.version != version) { 
+        // Параллельные запросы ждут первую отрисовку, а не рисуют карту заново 
+        auto json = std::make_shared<std::string>(); 
+        { 
+            json::EscapingStreamBuf buffer(*json); 
+            std::ostream out(&buffer); 
+            RenderMap(out); 
+        } 
+        rendered_map_ = { version, std::move(json) }; 
+    } 
+    return rendered_map_.json; 
+}
+
+void RequestHandler::RenderMap(const renderer::Viewport& viewport, std::ostream& out,
+                               std::optional<double> simplify_tolerance) const { 
+    if (!db_) { 
+        throw std::logic_error("Viewport map rendering requires a transport catalogue"); 
+    } 
+    std::shared_ptr<const renderer::MapIndex> index; 
+    { 
+        const uint64_t version = db_->GetVersion(); 
+        std::lock_guard guard(map_index_mutex_); 
+        if (!map_index_.index || map_index_.version != version) { 
+            map_index_ = { version, std::make_shared<renderer::MapIndex>(db_->SortBuses()) }; 
+        } 
+        index = map_index_.index; 
+    } 
+    renderer_->RenderSVG(*index, viewport, simplify_tolerance.value_or(renderer_->GetRenderSettings().simplify_tolerance), out); 
+}
+
+bool RequestHandler::CanRenderOnDemand() const {
+    return db_ != nullptr && renderer_ != nullptr;
+}
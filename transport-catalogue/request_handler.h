@@ -1,34 +1,83 @@
 #pragma once 
  
+#include "frozen_catalogue.h" 
 #include "json.h" 
 #include "map_renderer.h" 
 #include "transport_catalogue.h"
+#include "transport_router.h"
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
+#include <string>
 
 using namespace transport_catalogue; 
 using namespace domain;
 
 class RequestHandler {
 public:
-    RequestHandler(const TransportCatalogue& db, const renderer::MapRenderer& renderer)
-        : db_(db)
-        , renderer_(renderer) {
+    RequestHandler(const TransportCatalogue& db, const renderer::MapRenderer& renderer,
+                   const transport_router::TransportRouter* router = nullptr)
+        : db_(&db)
+        , renderer_(&renderer)
+        , router_(router) {
+    }
+
+    // Обслуживает запросы из неизменяемого снимка; карта берётся из снимка готовой
+    explicit RequestHandler(const FrozenCatalogue& frozen)
+        : frozen_(&frozen) {
     }
 
     // Возвращает информацию о маршруте (запрос Bus)
     std::optional<BusStat> GetBusStat(const std::string_view& bus_name) const;
     
     // Возвращает маршруты, проходящие через
-    const std::set<std::string_view> GetBusesByStop(const std::string_view& stop_name) const;
+    std::vector<std::string_view> GetBusesByStop(const std::string_view& stop_name) const;
+    
+    // Возвращает маршрут между остановками (запрос Route)
+    std::optional<transport_router::RouteInfo> BuildRoute(const std::string_view& from, const std::string_view& to) const;
     
     bool IsBusNumber(const std::string_view& bus_number) const;
     bool IsStopName(const std::string_view& stop_name) const;
 
     svg::Document RenderMap() const;
+    // Выводит SVG-представление карты
+    void RenderMap(std::ostream& out) const;
+    // SVG карты, экранированное для вставки в строку JSON. Результат хранится до
+    // изменения справочника (по TransportCatalogue::GetVersion), поэтому повторный
+    // запрос Map обходится копированием буфера. Безопасно вызывать из нескольких потоков.
+    // Карта с simplify_tolerance, отличным от настроек отрисовки, рисуется заново и не хранится
+    std::shared_ptr<const std::string> GetMapJsonString(std::optional<double> simplify_tolerance = std::nullopt) const;
+    // Выводит часть карты внутри viewport. Нужен справочник: индекс карты
+    // строится при первом таком запросе и хранится до изменения справочника.
+    // simplify_tolerance заменяет допуск упрощения линий из настроек отрисовки
+    void RenderMap(const renderer::Viewport& viewport, std::ostream& out,
+                   std::optional<double> simplify_tolerance = std::nullopt) const;
+    // Доступна ли отрисовка по запросу (часть карты или свой допуск упрощения):
+    // у снимка есть только готовая карта
+    bool CanRenderOnDemand() const;
 
 private:
     // RequestHandler использует агрегацию объектов "Транспортный Справочник" и "Визуализатор Карты" 
-    const TransportCatalogue& db_; 
-    const renderer::MapRenderer& renderer_;
+    // Вместо справочника может использоваться его неизменяемый снимок 
+    const TransportCatalogue* db_ = nullptr; 
+    const renderer::MapRenderer* renderer_ = nullptr;
+    const FrozenCatalogue* frozen_ = nullptr;
+    const transport_router::TransportRouter* router_ = nullptr;
+
+    struct RenderedMap {
+        uint64_t version = 0;
+        std::shared_ptr<const std::string> json;
+    };
+    struct MapIndexCache {
+        uint64_t version = 0;
+        std::shared_ptr<const renderer::MapIndex> index;
+    };
+    // У каждого кэша свой мьютекс: запросы части карты не ждут отрисовки полной
+    mutable std::mutex map_mutex_;
+    mutable RenderedMap rendered_map_;
+    mutable std::mutex map_index_mutex_;
+    mutable MapIndexCache map_index_;
 };
\ No newline at end of file
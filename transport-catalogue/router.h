@@ -0,0 +1,249 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/*
+ * Таблицы расстояний для ускорения поиска (ALT: A*, ориентиры, неравенство треугольника).
+ * Для ориентира с номером i и вершины v:
+ * from_landmark[i * vertex_count + v] — расстояние от ориентира до v,
+ * to_landmark[i * vertex_count + v] — расстояние от v до ориентира.
+ * Недостижимые вершины хранят бесконечность
+ */
+template <typename Weight>
+struct LandmarkTable {
+    std::vector<VertexId> landmarks;
+    std::vector<Weight> from_landmark;
+    std::vector<Weight> to_landmark;
+};
+
+/*
+ * Поиск кратчайшего пути алгоритмом Дейкстры.
+ * Граф не копируется и должен жить дольше маршрутизатора.
+ * Каждый запрос — один поиск от вершины from, прерываемый при достижении to.
+ * Если построены ориентиры, поиск идёт алгоритмом A* с нижними оценками из
+ * LandmarkTable и просматривает лишь небольшую часть графа.
+ * Состояние поиска локально для вызова, поэтому BuildRoute можно вызывать
+ * из нескольких потоков одновременно
+ */
+template <typename Weight>
+class Router {
+    static_assert(std::numeric_limits<Weight>::has_infinity);
+
+public:
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    explicit Router(const DirectedWeightedGraph<Weight>& graph)
+        : graph_(graph) {
+    }
+
+    // Считает расстояния от каждого ориентира и до него, распределяя поиски по потокам
+    void BuildLandmarks(std::vector<VertexId> landmarks, size_t threads_count = 1);
+    // Устанавливает готовые таблицы, например загруженные из базы
+    void SetLandmarks(LandmarkTable<Weight> table);
+    const LandmarkTable<Weight>& GetLandmarks() const;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Поиск без ориентиров; служит эталоном для проверки
+    std::optional<RouteInfo> BuildRouteWithoutLandmarks(VertexId from, VertexId to) const;
+
+private:
+    template <typename Potential>
+    std::optional<RouteInfo> Search(VertexId from, VertexId to, Potential potential) const;
+
+    Weight LowerBound(VertexId vertex, VertexId to) const;
+    std::vector<Weight> ComputeDistances(VertexId source, const std::vector<std::vector<EdgeId>>* reversed) const;
+
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+
+    const DirectedWeightedGraph<Weight>& graph_;
+    LandmarkTable<Weight> landmarks_;
+};
+
+template <typename Weight>
+void Router<Weight>::BuildLandmarks(std::vector<VertexId> landmarks, size_t threads_count) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<std::vector<EdgeId>> reversed(vertex_count);
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        reversed[graph_.GetEdge(edge_id).to].push_back(edge_id);
+    }
+
+    LandmarkTable<Weight> table;
+    table.from_landmark.resize(landmarks.size() * vertex_count);
+    table.to_landmark.resize(landmarks.size() * vertex_count);
+
+    // Задача 2i — поиск от ориентира i, задача 2i + 1 — поиск до него по обратным рёбрам
+    std::atomic<size_t> next_task{ 0 };
+    auto worker = [&] {
+        for (size_t task = next_task++; task < landmarks.size() * 2; task = next_task++) {
+            const size_t index = task / 2;
+            const bool backward = task % 2 == 1;
+            const auto distances = ComputeDistances(landmarks[index], backward ? &reversed : nullptr);
+            auto& target = backward ? table.to_landmark : table.from_landmark;
+            std::copy(distances.begin(), distances.end(), target.begin() + index * vertex_count);
+        }
+    };
+    threads_count = std::max<size_t>(1, std::min(threads_count, landmarks.size() * 2));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threads_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    table.landmarks = std::move(landmarks);
+    landmarks_ = std::move(table);
+}
+
+template <typename Weight>
+void Router<Weight>::SetLandmarks(LandmarkTable<Weight> table) {
+    const size_t expected = table.landmarks.size() * graph_.GetVertexCount();
+    if (table.from_landmark.size() != expected || table.to_landmark.size() != expected) {
+        throw std::invalid_argument("Landmark table does not match the graph");
+    }
+    landmarks_ = std::move(table);
+}
+
+template <typename Weight>
+const LandmarkTable<Weight>& Router<Weight>::GetLandmarks() const {
+    return landmarks_;
+}
+
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    if (landmarks_.landmarks.empty()) {
+        return BuildRouteWithoutLandmarks(from, to);
+    }
+    return Search(from, to, [this, to](VertexId vertex) {
+        return LowerBound(vertex, to);
+    });
+}
+
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRouteWithoutLandmarks(VertexId from, VertexId to) const {
+    return Search(from, to, [](VertexId) {
+        return Weight{};
+    });
+}
+
+template <typename Weight>
+template <typename Potential>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::Search(VertexId from, VertexId to, Potential potential) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<Weight> distances(vertex_count, INFINITE_WEIGHT);
+    std::vector<std::optional<EdgeId>> prev_edges(vertex_count);
+
+    // В очереди лежат пары (оценка длины пути через вершину, вершина)
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    distances[from] = Weight{};
+    queue.push({ potential(from), from });
+
+    while (!queue.empty()) {
+        const auto [estimate, vertex] = queue.top();
+        queue.pop();
+        if (vertex == to) {
+            break;
+        }
+        const Weight distance = distances[vertex];
+        if (estimate > distance + potential(vertex)) {
+            continue;
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight candidate = distance + edge.weight;
+            if (candidate < distances[edge.to]) {
+                const Weight bound = potential(edge.to);
+                if (bound == INFINITE_WEIGHT) {
+                    // Из edge.to цель недостижима
+                    continue;
+                }
+                distances[edge.to] = candidate;
+                prev_edges[edge.to] = edge_id;
+                queue.push({ candidate + bound, edge.to });
+            }
+        }
+    }
+
+    if (distances[to] == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+
+    RouteInfo result{ distances[to], {} };
+    for (VertexId vertex = to; prev_edges[vertex]; vertex = graph_.GetEdge(*prev_edges[vertex]).from) {
+        result.edges.push_back(*prev_edges[vertex]);
+    }
+    std::reverse(result.edges.begin(), result.edges.end());
+    return result;
+}
+
+template <typename Weight>
+Weight Router<Weight>::LowerBound(VertexId vertex, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    Weight result{};
+    for (size_t i = 0; i < landmarks_.landmarks.size(); ++i) {
+        const Weight* from_landmark = landmarks_.from_landmark.data() + i * vertex_count;
+        const Weight* to_landmark = landmarks_.to_landmark.data() + i * vertex_count;
+        // d(L, to) <= d(L, vertex) + d(vertex, to)
+        if (from_landmark[vertex] != INFINITE_WEIGHT) {
+            if (from_landmark[to] == INFINITE_WEIGHT) {
+                return INFINITE_WEIGHT;
+            }
+            result = std::max(result, from_landmark[to] - from_landmark[vertex]);
+        }
+        // d(vertex, L) <= d(vertex, to) + d(to, L)
+        if (to_landmark[to] != INFINITE_WEIGHT) {
+            if (to_landmark[vertex] == INFINITE_WEIGHT) {
+                return INFINITE_WEIGHT;
+            }
+            result = std::max(result, to_landmark[vertex] - to_landmark[to]);
+        }
+    }
+    return result;
+}
+
+template <typename Weight>
+std::vector<Weight> Router<Weight>::ComputeDistances(VertexId source, const std::vector<std::vector<EdgeId>>* reversed) const {
+    std::vector<Weight> distances(graph_.GetVertexCount(), INFINITE_WEIGHT);
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    distances[source] = Weight{};
+    queue.push({ Weight{}, source });
+
+    while (!queue.empty()) {
+        const auto [distance, vertex] = queue.top();
+        queue.pop();
+        if (distance > distances[vertex]) {
+            continue;
+        }
+        const auto& edges = reversed ? (*reversed)[vertex] : graph_.GetIncidentEdges(vertex);
+        for (const EdgeId edge_id : edges) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const VertexId next = reversed ? edge.from : edge.to;
+            if (distance + edge.weight < distances[next]) {
+                distances[next] = distance + edge.weight;
+                queue.push({ distances[next], next });
+            }
+        }
+    }
+    return distances;
+}
+
+} // namespace graph
@@ -0,0 +1,484 @@
+#include "serialization.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <set>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace serialization {
+
+using namespace std::literals;
+using namespace transport_catalogue;
+
+namespace {
+
+constexpr uint32_t BASE_MAGIC = 0x54414354; // "TCAT"
+/*
+ * Версия меняется только при несовместимом изменении формата. Совместимые
+ * изменения её не трогают: новые данные идут отдельной секцией (неизвестные
+ * секции пропускаются) или дописываются в конец существующей. Чтение
+ * дописанных полей проверяет AtEnd, так что база без них получает значения
+ * по умолчанию, а старая программа не дочитывает секцию до конца. Так
+ * добавлены landmark_count, simplify_tolerance и compact_output
+ */
+constexpr uint32_t BASE_VERSION = 1;
+
+enum class Section : uint32_t {
+    END = 0,
+    STOPS = 1,
+    BUSES = 2,
+    DISTANCES = 3,
+    RENDER_SETTINGS = 4,
+    BUS_STATS = 5,
+    ROUTING_SETTINGS = 6,
+    ROUTER_LANDMARKS = 7,
+};
+
+class Writer {
+public:
+    template <typename T>
+    void Write(T value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void WriteString(std::string_view str) {
+        Write(static_cast<uint32_t>(str.size()));
+        buffer_.append(str);
+    }
+
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Write(static_cast<uint64_t>(values.size()));
+        buffer_.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    void WriteColor(const svg::Color& color) {
+        Write(static_cast<uint8_t>(color.index()));
+        if (const auto* name = std::get_if<std::string>(&color)) {
+            WriteString(*name);
+        }
+        else if (const auto* rgba = std::get_if<svg::Rgba>(&color)) {
+            Write(rgba->red);
+            Write(rgba->green);
+            Write(rgba->blue);
+            Write(rgba->opacity);
+        }
+        else if (const auto* rgb = std::get_if<svg::Rgb>(&color)) {
+            Write(rgb->red);
+            Write(rgb->green);
+            Write(rgb->blue);
+        }
+    }
+
+    void WritePoint(svg::Point point) {
+        Write(point.x);
+        Write(point.y);
+    }
+
+    // Дописывает секцию, содержимое которой сформировано в section
+    void WriteSection(Section tag, const Writer& section) {
+        Write(tag);
+        Write(static_cast<uint64_t>(section.buffer_.size()));
+        buffer_.append(section.buffer_);
+    }
+
+    const std::string& GetBuffer() const {
+        return buffer_;
+    }
+
+private:
+    std::string buffer_;
+};
+
+class Reader {
+public:
+    Reader(const char* first, const char* last)
+        : pos_(first)
+        , end_(last) {
+    }
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Require(sizeof(T));
+        T value;
+        std::memcpy(&value, pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    std::string_view ReadString() {
+        const auto size = Read<uint32_t>();
+        Require(size);
+        std::string_view result(pos_, size);
+        pos_ += size;
+        return result;
+    }
+
+    // Читает число записей, каждая из которых занимает не меньше record_size байт.
+    // Число сверяется с остатком до выделения памяти под записи; произведение
+    // count * record_size может переполниться, поэтому сравниваем с частным
+    template <typename Count>
+    Count ReadCount(size_t record_size) {
+        const auto count = Read<Count>();
+        if (count > static_cast<uint64_t>(end_ - pos_) / record_size) {
+            throw SerializationError("Unexpected end of base"s);
+        }
+        return count;
+    }
+
+    template <typename T>
+    std::vector<T> ReadArray() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto size = ReadCount<uint64_t>(sizeof(T));
+        std::vector<T> result(size);
+        std::memcpy(result.data(), pos_, size * sizeof(T));
+        pos_ += size * sizeof(T);
+        return result;
+    }
+
+    svg::Color ReadColor() {
+        switch (Read<uint8_t>()) {
+        case 0:
+            return svg::NoneColor;
+        case 1:
+            return std::string(ReadString());
+        case 2: {
+            const auto red = Read<uint8_t>();
+            const auto green = Read<uint8_t>();
+            const auto blue = Read<uint8_t>();
+            return svg::Rgb(red, green, blue);
+        }
+        case 3: {
+            const auto red = Read<uint8_t>();
+            const auto green = Read<uint8_t>();
+            const auto blue = Read<uint8_t>();
+            return svg::Rgba(red, green, blue, Read<double>());
+        }
+        default:
+            throw SerializationError("Unknown color type"s);
+        }
+    }
+
+    svg::Point ReadPoint() {
+        const auto x = Read<double>();
+        return { x, Read<double>() };
+    }
+
+    // Отделяет следующие size байт в самостоятельный Reader
+    Reader Split(uint64_t size) {
+        Require(size);
+        Reader result(pos_, pos_ + size);
+        pos_ += size;
+        return result;
+    }
+
+    bool AtEnd() const {
+        return pos_ == end_;
+    }
+
+private:
+    void Require(uint64_t size) const {
+        if (static_cast<uint64_t>(end_ - pos_) < size) {
+            throw SerializationError("Unexpected end of base"s);
+        }
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+Writer SaveStops(const TransportCatalogue& db) {
+    Writer out;
+    out.Write(static_cast<uint32_t>(db.GetStopCount()));
+    for (StopId id = 0; id < db.GetStopCount(); ++id) {
+        StopPtr stop = db.GetStopById(id);
+        out.WriteString(stop->name);
+        out.Write(stop->coordinates.lat);
+        out.Write(stop->coordinates.lng);
+    }
+    return out;
+}
+
+Writer SaveBuses(const TransportCatalogue& db) {
+    Writer out;
+    out.Write(static_cast<uint32_t>(db.GetBusCount()));
+    for (BusId id = 0; id < db.GetBusCount(); ++id) {
+        BusPtr bus = db.GetBusById(id);
+        out.WriteString(bus->name);
+        out.Write(static_cast<uint8_t>(bus->type));
+        const StopIdRange route = db.GetRouteStopIds(id);
+        out.Write(static_cast<uint32_t>(route.size()));
+        for (StopId stop_id : route) {
+            out.Write(stop_id);
+        }
+    }
+    return out;
+}
+
+Writer SaveDistances(const TransportCatalogue& db) {
+    Writer out;
+    const DistanceTable& distances = db.GetStopDistances();
+    out.Write(static_cast<uint64_t>(distances.Size()));
+    distances.ForEach([&out](StopId from, StopId to, int distance) {
+        out.Write(from);
+        out.Write(to);
+        out.Write(static_cast<int32_t>(distance));
+    });
+    return out;
+}
+
+Writer SaveRenderSettings(const renderer::RenderSettings& settings) {
+    Writer out;
+    out.Write(settings.width);
+    out.Write(settings.height);
+    out.Write(settings.padding);
+    out.Write(settings.stop_radius);
+    out.Write(settings.line_width);
+    out.Write(static_cast<int32_t>(settings.bus_label_font_size));
+    out.WritePoint(settings.bus_label_offset);
+    out.Write(static_cast<int32_t>(settings.stop_label_font_size));
+    out.WritePoint(settings.stop_label_offset);
+    out.WriteColor(settings.underlayer_color);
+    out.Write(settings.underlayer_width);
+    out.Write(static_cast<uint32_t>(settings.color_palette.size()));
+    for (const auto& color : settings.color_palette) {
+        out.WriteColor(color);
+    }
+    out.Write(settings.simplify_tolerance);
+    out.Write(static_cast<uint8_t>(settings.compact_output.has_value()));
+    if (settings.compact_output) {
+        out.Write(static_cast<int32_t>(settings.compact_output->precision));
+        out.Write(static_cast<uint8_t>(settings.compact_output->relative_paths));
+    }
+    return out;
+}
+
+Writer SaveBusStats(const TransportCatalogue& db) {
+    Writer out;
+    out.Write(static_cast<uint32_t>(db.GetBusCount()));
+    for (BusId id = 0; id < db.GetBusCount(); ++id) {
+        const BusStat stat = *db.GetRouteStatistics(db.GetBusById(id)->name);
+        out.Write(static_cast<uint64_t>(stat.stops_count));
+        out.Write(static_cast<uint64_t>(stat.unique_stops_count));
+        out.Write(stat.route_length);
+        out.Write(stat.curvature);
+    }
+    return out;
+}
+
+Writer SaveRoutingSettings(const transport_router::RoutingSettings& settings) {
+    Writer out;
+    out.Write(static_cast<int32_t>(settings.bus_wait_time));
+    out.Write(settings.bus_velocity);
+    out.Write(static_cast<int32_t>(settings.landmark_count));
+    return out;
+}
+
+Writer SaveRouterLandmarks(const graph::LandmarkTable<double>& table) {
+    Writer out;
+    std::vector<uint64_t> landmarks(table.landmarks.begin(), table.landmarks.end());
+    out.WriteArray(landmarks);
+    out.WriteArray(table.from_landmark);
+    out.WriteArray(table.to_landmark);
+    return out;
+}
+
+void LoadStops(Reader& in, TransportCatalogue& db) {
+    // Остановка занимает не меньше длины имени и двух координат
+    const auto count = in.ReadCount<uint32_t>(sizeof(uint32_t) + sizeof(double) * 2);
+    for (uint32_t i = 0; i < count; ++i) {
+        const std::string_view name = in.ReadString();
+        const auto lat = in.Read<double>();
+        const auto lng = in.Read<double>();
+        db.AddStop(name, { lat, lng });
+    }
+}
+
+// Остановка по номеру из базы; номер вне справочника означает повреждённую базу
+StopPtr ReadStop(Reader& in, const TransportCatalogue& db) {
+    const auto id = in.Read<StopId>();
+    if (id >= db.GetStopCount()) {
+        throw SerializationError("Unknown stop id "s + std::to_string(id));
+    }
+    return db.GetStopById(id);
+}
+
+void LoadBuses(Reader& in, TransportCatalogue& db) {
+    // Маршрут занимает не меньше длины имени, типа и числа остановок
+    const auto count = in.ReadCount<uint32_t>(sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t));
+    std::vector<std::tuple<std::string_view, std::vector<StopPtr>, bool>> routes;
+    routes.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const std::string_view name = in.ReadString();
+        const auto type = static_cast<RouteType>(in.Read<uint8_t>());
+        std::vector<StopPtr> stops(in.ReadCount<uint32_t>(sizeof(StopId)));
+        for (auto& stop : stops) {
+            stop = ReadStop(in, db);
+        }
+        routes.emplace_back(name, std::move(stops), type == RouteType::Round);
+    }
+    db.AddRoutes(routes);
+}
+
+void LoadDistances(Reader& in, TransportCatalogue& db) {
+    const auto count = in.ReadCount<uint64_t>(sizeof(StopId) * 2 + sizeof(int32_t));
+    for (uint64_t i = 0; i < count; ++i) {
+        const StopPtr from = ReadStop(in, db);
+        const StopPtr to = ReadStop(in, db);
+        db.SetStopDistance(from, to, in.Read<int32_t>());
+    }
+}
+
+renderer::RenderSettings LoadRenderSettings(Reader& in) {
+    renderer::RenderSettings settings;
+    settings.width = in.Read<double>();
+    settings.height = in.Read<double>();
+    settings.padding = in.Read<double>();
+    settings.stop_radius = in.Read<double>();
+    settings.line_width = in.Read<double>();
+    settings.bus_label_font_size = in.Read<int32_t>();
+    settings.bus_label_offset = in.ReadPoint();
+    settings.stop_label_font_size = in.Read<int32_t>();
+    settings.stop_label_offset = in.ReadPoint();
+    settings.underlayer_color = in.ReadColor();
+    settings.underlayer_width = in.Read<double>();
+    // Цвет занимает не меньше байта с его типом
+    settings.color_palette.resize(in.ReadCount<uint32_t>(sizeof(uint8_t)));
+    for (auto& color : settings.color_palette) {
+        color = in.ReadColor();
+    }
+    if (!in.AtEnd()) {
+        settings.simplify_tolerance = in.Read<double>();
+    }
+    if (!in.AtEnd() && in.Read<uint8_t>()) {
+        svg::CompactOptions options;
+        options.precision = in.Read<int32_t>();
+        options.relative_paths = in.Read<uint8_t>() != 0;
+        settings.compact_output = options;
+    }
+    return settings;
+}
+
+transport_router::RoutingSettings LoadRoutingSettings(Reader& in) {
+    transport_router::RoutingSettings settings;
+    settings.bus_wait_time = in.Read<int32_t>();
+    settings.bus_velocity = in.Read<double>();
+    if (!in.AtEnd()) {
+        settings.landmark_count = in.Read<int32_t>();
+    }
+    return settings;
+}
+
+graph::LandmarkTable<double> LoadRouterLandmarks(Reader& in) {
+    graph::LandmarkTable<double> table;
+    const auto landmarks = in.ReadArray<uint64_t>();
+    table.landmarks.assign(landmarks.begin(), landmarks.end());
+    table.from_landmark = in.ReadArray<double>();
+    table.to_landmark = in.ReadArray<double>();
+    return table;
+}
+
+std::vector<BusStat> LoadBusStats(Reader& in) {
+    std::vector<BusStat> stats(in.ReadCount<uint32_t>(sizeof(uint64_t) * 2 + sizeof(double) * 2));
+    for (auto& stat : stats) {
+        stat.stops_count = in.Read<uint64_t>();
+        stat.unique_stops_count = in.Read<uint64_t>();
+        stat.route_length = in.Read<double>();
+        stat.curvature = in.Read<double>();
+    }
+    return stats;
+}
+
+} // namespace
+
+void SaveBase(const TransportCatalogue& db, const BaseSettings& settings, std::ostream& output) {
+    Writer out;
+    out.Write(BASE_MAGIC);
+    out.Write(BASE_VERSION);
+    out.WriteSection(Section::STOPS, SaveStops(db));
+    out.WriteSection(Section::BUSES, SaveBuses(db));
+    out.WriteSection(Section::DISTANCES, SaveDistances(db));
+    out.WriteSection(Section::RENDER_SETTINGS, SaveRenderSettings(settings.render_settings));
+    out.WriteSection(Section::BUS_STATS, SaveBusStats(db));
+    if (settings.routing_settings) {
+        out.WriteSection(Section::ROUTING_SETTINGS, SaveRoutingSettings(*settings.routing_settings));
+    }
+    if (!settings.route_landmarks.landmarks.empty()) {
+        out.WriteSection(Section::ROUTER_LANDMARKS, SaveRouterLandmarks(settings.route_landmarks));
+    }
+    out.WriteSection(Section::END, Writer{});
+
+    const std::string& buffer = out.GetBuffer();
+    output.write(buffer.data(), buffer.size());
+    if (!output) {
+        throw SerializationError("Failed to write base"s);
+    }
+}
+
+BaseSettings LoadBase(std::istream& input, TransportCatalogue& db) {
+    const std::string buffer{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    Reader in(buffer.data(), buffer.data() + buffer.size());
+    if (in.Read<uint32_t>() != BASE_MAGIC) {
+        throw SerializationError("Not a transport catalogue base"s);
+    }
+    if (const auto version = in.Read<uint32_t>(); version != BASE_VERSION) {
+        throw SerializationError("Unsupported base version "s + std::to_string(version));
+    }
+
+    BaseSettings settings;
+    std::vector<BusStat> bus_stats;
+    // Каждая известная секция встречается не больше одного раза
+    std::set<Section> loaded;
+    while (true) {
+        const auto tag = in.Read<Section>();
+        Reader section = in.Split(in.Read<uint64_t>());
+        if (tag == Section::END) {
+            break;
+        }
+        if (tag <= Section::ROUTER_LANDMARKS && !loaded.insert(tag).second) {
+            throw SerializationError("Duplicate base section "s + std::to_string(static_cast<uint32_t>(tag)));
+        }
+        switch (tag) {
+        case Section::STOPS:
+            LoadStops(section, db);
+            break;
+        case Section::BUSES:
+            LoadBuses(section, db);
+            break;
+        case Section::DISTANCES:
+            LoadDistances(section, db);
+            break;
+        case Section::RENDER_SETTINGS:
+            settings.render_settings = LoadRenderSettings(section);
+            break;
+        case Section::BUS_STATS:
+            bus_stats = LoadBusStats(section);
+            break;
+        case Section::ROUTING_SETTINGS:
+            settings.routing_settings = LoadRoutingSettings(section);
+            break;
+        case Section::ROUTER_LANDMARKS:
+            settings.route_landmarks = LoadRouterLandmarks(section);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (bus_stats.size() == db.GetBusCount()) {
+        db.Finalize(std::move(bus_stats));
+    }
+    else {
+        db.Finalize();
+    }
+    return settings;
+}
+
+} // namespace serialization
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "map_renderer.h"
+#include "router.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+
+namespace serialization {
+
+class SerializationError : public std::runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+// Всё, что сохраняется в базе помимо самого справочника
+struct BaseSettings {
+    renderer::RenderSettings render_settings;
+    std::optional<transport_router::RoutingSettings> routing_settings;
+    // Таблицы ориентиров маршрутизатора; пустые, если ускорение не строилось
+    graph::LandmarkTable<double> route_landmarks;
+};
+
+/*
+ * Двоичный формат базы: заголовок (сигнатура и версия), затем секции
+ * вида "тег, размер, данные". Числа пишутся в порядке байтов машины.
+ * Секции: остановки, маршруты, расстояния, настройки отрисовки,
+ * статистика маршрутов, посчитанная TransportCatalogue::Finalize,
+ * и, если заданы, настройки маршрутизации и таблицы ориентиров маршрутизатора.
+ * Неизвестные секции при чтении пропускаются
+ */
+void SaveBase(const transport_catalogue::TransportCatalogue& db, const BaseSettings& settings, std::ostream& output);
+
+// Наполняет пустой справочник из базы и возвращает сохранённые настройки
+BaseSettings LoadBase(std::istream& input, transport_catalogue::TransportCatalogue& db);
+
+} // namespace serialization
@@ -1,5 +1,9 @@
 #include "svg.h"
 
+#include <charconv>
+#include <cmath>
+#include <sstream>
+
 namespace svg {
 
 using namespace std::literals;
@@ -161,4 +165,310 @@ void Document::Render(std::ostream& out) const {
     out << "</svg>"sv;
 }
 
-}  // namespace svg
\ No newline at end of file
+// ---------- StyleTable --------------
+
+namespace {
+
+// При выводе в поток BufferWriter сбрасывает буфер, когда в нём набирается столько байт
+const size_t SINK_BUFFER_SIZE = 16 * 1024;
+
+// Переводит атрибуты вида ` name="value"` в объявления CSS `name:value;`
+void AppendRule(std::string& rule, std::string_view attrs) {
+    size_t position = 0;
+    while ((position = attrs.find('=', position)) != std::string_view::npos) {
+        const size_t name_start = attrs.rfind(' ', position) + 1;
+        const size_t value_start = position + 2;
+        const size_t value_end = attrs.find('"', value_start);
+        rule.append(attrs.substr(name_start, position - name_start));
+        rule += ':';
+        rule.append(attrs.substr(value_start, value_end - value_start));
+        rule += ';';
+        position = value_end + 1;
+    }
+}
+
+} // namespace
+
+StyleTable::StyleId StyleTable::AddPath(const PathStyle& style) {
+    std::ostringstream attrs;
+    style.Render(attrs);
+    Style result{ attrs.str(), {}, {} };
+    AppendRule(result.rule, result.attrs);
+    styles_.push_back(std::move(result));
+    return static_cast<StyleId>(styles_.size() - 1);
+}
+
+StyleTable::StyleId StyleTable::AddText(const PathStyle& style, Point offset, uint32_t font_size,
+                                        std::string_view font_family, std::string_view font_weight) {
+    std::ostringstream attrs;
+    style.Render(attrs);
+    // Тот же вывод, что и в Text::RenderObject после координат опорной точки
+    std::ostringstream text_attrs;
+    text_attrs << "dx=\""sv << offset.x << "\" dy=\""sv << offset.y << "\" "sv;
+    text_attrs << "font-size=\""sv << font_size << "\""sv;
+    if (!font_family.empty()) text_attrs << " font-family=\""sv << font_family << "\" "sv;
+    if (!font_weight.empty()) text_attrs << "font-weight=\""sv << font_weight << "\""sv;
+    
+    std::ostringstream rule;
+    rule << "font-size:"sv << font_size << "px;"sv;
+    if (!font_family.empty()) rule << "font-family:"sv << font_family << ';';
+    if (!font_weight.empty()) rule << "font-weight:"sv << font_weight << ';';
+    Style result{ attrs.str(), text_attrs.str(), {}, offset };
+    AppendRule(result.rule, result.attrs);
+    result.rule += rule.str();
+    styles_.push_back(std::move(result));
+    return static_cast<StyleId>(styles_.size() - 1);
+}
+
+std::string_view StyleTable::GetAttrs(StyleId id) const {
+    return styles_[id].attrs;
+}
+
+std::string_view StyleTable::GetTextAttrs(StyleId id) const {
+    return styles_[id].text_attrs;
+}
+
+std::string_view StyleTable::GetRule(StyleId id) const {
+    return styles_[id].rule;
+}
+
+Point StyleTable::GetTextOffset(StyleId id) const {
+    return styles_[id].offset;
+}
+
+size_t StyleTable::GetSize() const {
+    return styles_.size();
+}
+
+// ---------- BufferWriter ------------
+
+BufferWriter::BufferWriter(std::string& output, const StyleTable& styles, std::optional<CompactOptions> compact)
+    : output_(output)
+    , styles_(styles)
+    , compact_(compact) {
+    if (compact_) {
+        scale_ = std::pow(10.0, compact_->precision);
+        quote_ = '\'';
+    }
+}
+
+BufferWriter::BufferWriter(std::ostream& sink, const StyleTable& styles, std::optional<CompactOptions> compact)
+    : BufferWriter(buffer_, styles, compact) {
+    sink_ = &sink;
+    buffer_.reserve(SINK_BUFFER_SIZE * 2);
+}
+
+BufferWriter::~BufferWriter() {
+    Flush();
+}
+
+void BufferWriter::BeginDocument() {
+    if (!compact_) {
+        output_ += "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+        output_ += "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
+        return;
+    }
+    output_ += "<?xml version='1.0' encoding='UTF-8'?><svg xmlns='http://www.w3.org/2000/svg' version='1.1'><style>"sv;
+    for (StyleTable::StyleId id = 0; id < styles_.GetSize(); ++id) {
+        output_ += ".s"sv;
+        output_ += std::to_string(id);
+        output_ += '{';
+        output_ += styles_.GetRule(id);
+        output_ += '}';
+    }
+    output_ += "</style>"sv;
+}
+
+void BufferWriter::EndDocument() {
+    output_ += "</svg>"sv;
+    Flush();
+}
+
+void BufferWriter::Circle(Point center, double radius, StyleTable::StyleId style) {
+    BeginObject();
+    output_ += "<circle"sv;
+    AppendAttr("cx"sv, center.x);
+    AppendAttr("cy"sv, center.y);
+    AppendAttr("r"sv, radius);
+    AppendClass(style);
+    EndObject();
+}
+
+void BufferWriter::BeginPolyline() {
+    BeginObject();
+    if (compact_ && compact_->relative_paths) {
+        output_ += "<path d='"sv;
+    }
+    else {
+        output_ += "<polyline points="sv;
+        output_ += quote_;
+    }
+    first_point_ = true;
+}
+
+void BufferWriter::AddPoint(Point point) {
+    if (compact_ && compact_->relative_paths) {
+        // Первая точка задаёт начало пути, следующие — сдвиг от предыдущей.
+        // Сдвиги считаются между округлёнными точками, поэтому ошибка не накапливается
+        const Point rounded = { std::round(point.x * scale_) / scale_, std::round(point.y * scale_) / scale_ };
+        // Числа пути разделяются пробелом, если следующее не начинается с минуса
+        const auto append_separated = [this](double value) {
+            if (std::round(value * scale_) >= 0.0) {
+                output_ += ' ';
+            }
+            AppendRounded(value);
+        };
+        if (first_point_) {
+            output_ += 'M';
+            AppendRounded(rounded.x);
+            append_separated(rounded.y);
+            relative_path_ = false;
+        }
+        else {
+            const Point delta = { rounded.x - last_point_.x, rounded.y - last_point_.y };
+            if (relative_path_) {
+                append_separated(delta.x);
+            }
+            else {
+                output_ += 'l';
+                AppendRounded(delta.x);
+                relative_path_ = true;
+            }
+            append_separated(delta.y);
+        }
+        last_point_ = rounded;
+        first_point_ = false;
+        return;
+    }
+    if (!first_point_) {
+        output_ += ' ';
+    }
+    first_point_ = false;
+    if (compact_) {
+        AppendRounded(point.x);
+        output_ += ',';
+        AppendRounded(point.y);
+        return;
+    }
+    AppendNumber(point.x);
+    output_ += ',';
+    AppendNumber(point.y);
+}
+
+void BufferWriter::EndPolyline(StyleTable::StyleId style) {
+    output_ += quote_;
+    AppendClass(style);
+    EndObject();
+}
+
+void BufferWriter::Text(Point position, std::string_view data, StyleTable::StyleId style) {
+    BeginObject();
+    output_ += "<text"sv;
+    if (compact_) {
+        AppendClass(style);
+        const Point offset = styles_.GetTextOffset(style);
+        AppendAttr("x"sv, position.x + offset.x);
+        AppendAttr("y"sv, position.y + offset.y);
+        output_ += '>';
+    }
+    else {
+        output_ += styles_.GetAttrs(style);
+        output_ += " x=\""sv;
+        AppendNumber(position.x);
+        output_ += "\" y=\""sv;
+        AppendNumber(position.y);
+        output_ += "\" "sv;
+        output_ += styles_.GetTextAttrs(style);
+        output_ += '>';
+    }
+    output_ += data;
+    output_ += "</text>"sv;
+    if (!compact_) {
+        output_ += '\n';
+    }
+}
+
+void BufferWriter::BeginObject() {
+    // Отступ объектов внутри <svg>, как у Document::Render
+    if (!compact_) {
+        output_ += "  "sv;
+    }
+}
+
+void BufferWriter::EndObject() {
+    output_ += compact_ ? "/>"sv : "/>\n"sv;
+    if (sink_ && buffer_.size() >= SINK_BUFFER_SIZE) {
+        Flush();
+    }
+}
+
+void BufferWriter::AppendNumber(double value) {
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+    output_.append(buffer, result.ptr);
+}
+
+void BufferWriter::AppendRounded(double value) {
+    double rounded = std::round(value * scale_) / scale_;
+    if (rounded == 0.0) {
+        // Без знака у отрицательного нуля
+        rounded = 0.0;
+    }
+    char buffer[64];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), rounded, std::chars_format::fixed, compact_->precision);
+    if (result.ec != std::errc{}) {
+        AppendNumber(value);
+        return;
+    }
+    std::string_view text(buffer, static_cast<size_t>(result.ptr - buffer));
+    if (compact_->precision > 0) {
+        while (text.back() == '0') {
+            text.remove_suffix(1);
+        }
+        if (text.back() == '.') {
+            text.remove_suffix(1);
+        }
+    }
+    // Ноль целой части перед дробной не нужен: 0.5 выводится как .5
+    if (text.front() == '-') {
+        output_ += '-';
+        text.remove_prefix(1);
+    }
+    if (text.size() > 1 && text[0] == '0' && text[1] == '.') {
+        text.remove_prefix(1);
+    }
+    output_ += text;
+}
+
+void BufferWriter::AppendAttr(std::string_view name, double value) {
+    output_ += ' ';
+    output_ += name;
+    output_ += '=';
+    output_ += quote_;
+    if (compact_) {
+        AppendRounded(value);
+    }
+    else {
+        AppendNumber(value);
+    }
+    output_ += quote_;
+}
+
+void BufferWriter::AppendClass(StyleTable::StyleId style) {
+    if (!compact_) {
+        output_ += styles_.GetAttrs(style);
+        return;
+    }
+    output_ += " class='s"sv;
+    output_ += std::to_string(style);
+    output_ += '\'';
+}
+
+void BufferWriter::Flush() {
+    if (sink_ && !buffer_.empty()) {
+        sink_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+}
+
+}  // namespace svg
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <variant>
@@ -317,4 +318,119 @@ private:
     std::vector<std::unique_ptr<Object>> objects_;
 };
 
+/*
+ * Набор атрибутов контура и заливки без самой фигуры.
+ * Служит заготовкой стиля для StyleTable
+ */
+class PathStyle final : public PathProps<PathStyle> {
+public:
+    void Render(std::ostream& out) const {
+        RenderAttrs(out);
+    }
+};
+
+/*
+ * Таблица стилей для BufferWriter: атрибуты выводятся в строки один раз,
+ * примитивы ссылаются на них по номеру. Текстовый стиль, кроме атрибутов
+ * контура, хранит смещение, размер и шрифт надписи
+ */
+class StyleTable {
+public:
+    using StyleId = uint32_t;
+
+    StyleId AddPath(const PathStyle& style);
+    StyleId AddText(const PathStyle& style, Point offset, uint32_t font_size,
+                    std::string_view font_family, std::string_view font_weight);
+
+    // Атрибуты контура и заливки, с ведущим пробелом
+    std::string_view GetAttrs(StyleId id) const;
+    // Атрибуты надписи от dx до закрывающей скобки тега
+    std::string_view GetTextAttrs(StyleId id) const;
+    // Те же атрибуты (кроме смещения надписи) объявлениями CSS для класса стиля
+    std::string_view GetRule(StyleId id) const;
+    // Смещение надписи текстового стиля
+    Point GetTextOffset(StyleId id) const;
+    size_t GetSize() const;
+
+private:
+    struct Style {
+        std::string attrs;
+        std::string text_attrs;
+        std::string rule;
+        Point offset = { 0.0, 0.0 };
+    };
+
+    std::vector<Style> styles_;
+};
+
+/*
+ * Настройки компактного вывода BufferWriter. Стили выводятся один раз классами
+ * в <style>, элементы ссылаются на них атрибутом class; смещение надписи
+ * прибавляется к её координатам. Координаты округляются до precision знаков
+ * после запятой без лишних нулей, атрибуты берутся в одинарные кавычки, которые
+ * не нужно экранировать в строке JSON, отступов и переводов строк нет.
+ * С relative_paths ломаные выводятся элементами <path> в относительных координатах
+ */
+struct CompactOptions {
+    int precision = 2;
+    bool relative_paths = true;
+};
+
+/*
+ * Выводит SVG-документ прямо в строку без построения объектов Document.
+ * Числа форматируются std::to_chars так же, как их выводит std::ostream
+ * (точность 6), поэтому результат побайтно совпадает с Document::Render.
+ * Если заданы CompactOptions, документ выводится в компактной форме.
+ * Ломаная выводится по точкам между BeginPolyline и EndPolyline.
+ * Вместо строки можно передать поток: тогда документ копится в небольшом
+ * буфере, который сбрасывается в поток по мере заполнения, в EndDocument
+ * и при разрушении, и весь документ целиком в памяти не хранится
+ */
+class BufferWriter {
+public:
+    BufferWriter(std::string& output, const StyleTable& styles,
+                 std::optional<CompactOptions> compact = std::nullopt);
+    BufferWriter(std::ostream& sink, const StyleTable& styles,
+                 std::optional<CompactOptions> compact = std::nullopt);
+    BufferWriter(const BufferWriter&) = delete;
+    BufferWriter& operator=(const BufferWriter&) = delete;
+    ~BufferWriter();
+
+    void BeginDocument();
+    void EndDocument();
+
+    void Circle(Point center, double radius, StyleTable::StyleId style);
+
+    void BeginPolyline();
+    void AddPoint(Point point);
+    void EndPolyline(StyleTable::StyleId style);
+
+    void Text(Point position, std::string_view data, StyleTable::StyleId style);
+
+private:
+    void BeginObject();
+    void EndObject();
+    void AppendNumber(double value);
+    // Число, округлённое до compact_->precision знаков после запятой
+    void AppendRounded(double value);
+    void AppendAttr(std::string_view name, double value);
+    void AppendClass(StyleTable::StyleId style);
+    void Flush();
+
+    // Буфер для вывода в поток; объявлен до output_, который на него ссылается
+    std::string buffer_;
+    std::ostream* sink_ = nullptr;
+    std::string& output_;
+    const StyleTable& styles_;
+    std::optional<CompactOptions> compact_;
+    // Множитель округления, 10 в степени precision
+    double scale_ = 1.0;
+    char quote_ = '"';
+    bool first_point_ = true;
+    // Предыдущая точка относительного пути, уже округлённая
+    Point last_point_ = { 0.0, 0.0 };
+    // После начальной точки пути уже выведена команда l
+    bool relative_path_ = false;
+};
+
 }  // namespace svg
\ No newline at end of file
@@ -1,26 +1,58 @@
 #include "transport_catalogue.h"
 
+#include <thread>
+
 namespace transport_catalogue { 
  
 void TransportCatalogue::AddStop(std::string_view stop_name, const geo::Coordinates coordinates) { 
-    stops_.push_back({ std::string(stop_name), coordinates, {} }); 
+    ResetFinalized(); 
+    const StopId id = static_cast<StopId>(stops_.size()); 
+    stops_.push_back({ std::string(stop_name), coordinates, {}, id }); 
     stopname_to_stop_[stops_.back().name] = &stops_.back(); 
+    stop_coordinates_.push_back(coordinates); 
+    stop_points_.push_back(geo::ToSpherePoint(coordinates)); 
 } 
  
 void TransportCatalogue::AddRoute(std::string_view bus_name, const std::vector<StopPtr> stops, bool is_circle) { 
+    BusPtr bus = PushRoute(bus_name, stops, is_circle); 
+    for (const auto& route_stop : bus->stops) { 
+        stopname_to_stop_.at(route_stop->name)->buses_by_stop.insert(bus->name); 
+    } 
+}
+
+void TransportCatalogue::AddRoutes(const std::vector<std::tuple<std::string_view, std::vector<StopPtr>, bool>>& routes) { 
+    std::vector<BusPtr> added; 
+    added.reserve(routes.size()); 
+    for (const auto& [bus_name, stops, is_circle] : routes) { 
+        added.push_back(PushRoute(bus_name, stops, is_circle)); 
+    } 
+    // Обходим маршруты в порядке имён: каждое новое имя попадает в конец множества, 
+    // и вставка с подсказкой end() выполняется за амортизированное O(1) 
+    std::sort(added.begin(), added.end(), [](BusPtr lhs, BusPtr rhs) { 
+        return lhs->name < rhs->name; 
+    }); 
+    for (BusPtr bus : added) { 
+        for (const auto& route_stop : bus->stops) { 
+            auto& buses_by_stop = stopname_to_stop_.at(route_stop->name)->buses_by_stop; 
+            buses_by_stop.emplace_hint(buses_by_stop.end(), bus->name); 
+        } 
+    } 
+}
+
+BusPtr TransportCatalogue::PushRoute(std::string_view bus_name, const std::vector<StopPtr>& stops, bool is_circle) { 
+    ResetFinalized(); 
     RouteType type = RouteType::Straight; 
     if (is_circle) { 
         type = RouteType::Round; 
     } 
-    buses_.push_back({ std::string(bus_name), stops, type }); 
+    const BusId id = static_cast<BusId>(buses_.size()); 
+    buses_.push_back({ std::string(bus_name), stops, type, id }); 
     busname_to_bus_[buses_.back().name] = &buses_.back(); 
-    for (const auto& route_stop : stops) { 
-        for (auto& stop_ : stops_) { 
-            if (stop_.name == route_stop->name) { 
-                stop_.buses_by_stop.insert(bus_name); 
-            } 
-        } 
+    for (const auto& stop : stops) { 
+        route_stop_ids_.push_back(stop->id); 
     } 
+    route_offsets_.push_back(static_cast<uint32_t>(route_stop_ids_.size())); 
+    return &buses_.back(); 
 }
 
 BusPtr TransportCatalogue::GetRoute(const std::string_view& bus_name) const { 
@@ -38,22 +70,93 @@ StopPtr TransportCatalogue::GetStop(const std::string_view& stop_name) const {
 }
 
 void TransportCatalogue::SetStopDistance(StopPtr from, StopPtr to, const int distance) { 
-    stops_distances_[{from, to}] = distance; 
+    if (!from || !to) { 
+        throw std::invalid_argument("stop not found"); 
+    } 
+    ResetFinalized(); 
+    stops_distances_.Set(from->id, to->id, distance); 
 } 
  
 int TransportCatalogue::GetStopDistance(StopPtr from, StopPtr to) const { 
-    if (stops_distances_.count({from, to})) return stops_distances_.at({from, to}); 
-    else if (stops_distances_.count({to, from})) return stops_distances_.at({to, from}); 
-    else return 0; 
+    return stops_distances_.Get(from->id, to->id); 
+}
+
+void TransportCatalogue::BuildStopAdjacency() { 
+    stops_distances_.BuildAdjacency(stops_.size()); 
+}
+
+const DistanceTable& TransportCatalogue::GetStopDistances() const { 
+    return stops_distances_; 
 }
     
 std::optional<BusStat> TransportCatalogue::GetRouteStatistics(const std::string_view& bus_name) const {
-    BusStat statistics{}; 
     BusPtr bus = GetRoute(bus_name); 
     if (!bus) { 
         throw std::invalid_argument("bus not found"); 
     } 
-     
+    if (is_finalized_) { 
+        return bus_stats_[bus->id]; 
+    } 
+    StatisticsBuffers buffers; 
+    return ComputeRouteStatistics(bus, buffers); 
+}
+
+void TransportCatalogue::Finalize(size_t threads_count) { 
+    const auto start = std::chrono::steady_clock::now(); 
+    BuildStopAdjacency(); 
+ 
+    bus_stats_.assign(buses_.size(), BusStat{}); 
+    threads_count = std::max<size_t>(1, std::min(threads_count, buses_.size())); 
+    auto compute_range = [this](size_t first, size_t last) { 
+        StatisticsBuffers buffers; 
+        for (size_t id = first; id < last; ++id) { 
+            bus_stats_[id] = ComputeRouteStatistics(&buses_[id], buffers); 
+        } 
+    }; 
+ 
+    const size_t chunk = (buses_.size() + threads_count - 1) / threads_count; 
+    std::vector<std::thread> workers; 
+    for (size_t first = chunk; first < buses_.size(); first += chunk) { 
+        workers.emplace_back(compute_range, first, std::min(first + chunk, buses_.size())); 
+    } 
+    compute_range(0, std::min(chunk, buses_.size())); 
+    for (auto& worker : workers) { 
+        worker.join(); 
+    } 
+ 
+    is_finalized_ = true; 
+    finalize_duration_ = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start); 
+} 
+ 
+void TransportCatalogue::Finalize(std::vector<BusStat> bus_stats) { 
+    if (bus_stats.size() != buses_.size()) { 
+        throw std::invalid_argument("bus statistics do not match buses"); 
+    } 
+    const auto start = std::chrono::steady_clock::now(); 
+    BuildStopAdjacency(); 
+    bus_stats_ = std::move(bus_stats); 
+    is_finalized_ = true; 
+    finalize_duration_ = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start); 
+} 
+ 
+std::chrono::nanoseconds TransportCatalogue::GetFinalizeDuration() const { 
+    return finalize_duration_; 
+} 
+ 
+uint64_t TransportCatalogue::GetVersion() const { 
+    return version_; 
+} 
+ 
+void TransportCatalogue::ResetFinalized() { 
+    ++version_; 
+    if (is_finalized_) { 
+        is_finalized_ = false; 
+        bus_stats_.clear(); 
+    } 
+} 
+ 
+BusStat TransportCatalogue::ComputeRouteStatistics(BusPtr bus, StatisticsBuffers& buffers) const { 
+    BusStat statistics{}; 
     if (bus->type == RouteType::Round) { 
         statistics.stops_count = bus->stops.size(); 
     } 
@@ -61,7 +164,9 @@ std::optional<BusStat> TransportCatalogue::GetRouteStatistics(const std::string_
         statistics.stops_count = bus->stops.size() * 2 - 1; 
     } 
      
-    auto unique_stops = bus->stops; 
+    const StopIdRange route = GetRouteStopIds(bus->id); 
+    std::vector<StopId>& unique_stops = buffers.unique_stops; 
+    unique_stops.assign(route.begin(), route.end()); 
     std::sort(unique_stops.begin(), unique_stops.end()); 
     auto it = unique(unique_stops.begin(), unique_stops.end()); 
     unique_stops.erase(it, unique_stops.end()); 
@@ -69,17 +174,21 @@ std::optional<BusStat> TransportCatalogue::GetRouteStatistics(const std::string_
  
     int route_length = 0; 
     double geo_distance = 0.0; 
+    std::vector<double>& segments = buffers.segments; 
+    segments.resize(route.size()); 
+    geo::ComputeDistances(stop_points_.data(), route.begin(), route.size(), segments.data()); 
  
-    for (size_t i = 0; i < bus->stops.size() - 1; ++i) { 
-        auto from = bus->stops[i]; 
-        auto to = bus->stops[i + 1]; 
+    for (size_t i = 0; i + 1 < route.size(); ++i) { 
+        const StopId from_id = route[i]; 
+        const StopId to_id = route[i + 1]; 
+        const double segment = segments[i]; 
         if (bus->type == RouteType::Round) { 
-            geo_distance += geo::ComputeDistance(from->coordinates, to->coordinates); 
-            route_length += GetStopDistance(from, to); 
+            geo_distance += segment; 
+            route_length += stops_distances_.Get(from_id, to_id); 
         } 
         else { 
-            geo_distance += geo::ComputeDistance(from->coordinates, to->coordinates) * 2; 
-            route_length += GetStopDistance(from, to) + GetStopDistance(to, from); 
+            geo_distance += segment * 2; 
+            route_length += stops_distances_.Get(from_id, to_id) + stops_distances_.Get(to_id, from_id); 
         } 
     } 
      
@@ -97,4 +206,28 @@ const std::map<std::string_view, BusPtr> TransportCatalogue::SortBuses() const {
     return result; 
 }
 
+size_t TransportCatalogue::GetStopCount() const { 
+    return stops_.size(); 
+} 
+ 
+size_t TransportCatalogue::GetBusCount() const { 
+    return buses_.size(); 
+} 
+ 
+StopPtr TransportCatalogue::GetStopById(StopId id) const { 
+    return &stops_.at(id); 
+} 
+ 
+BusPtr TransportCatalogue::GetBusById(BusId id) const { 
+    return &buses_.at(id); 
+} 
+ 
+const std::vector<geo::Coordinates>& TransportCatalogue::GetStopsCoordinates() const { 
+    return stop_coordinates_; 
+} 
+ 
+StopIdRange TransportCatalogue::GetRouteStopIds(BusId id) const { 
+    return { route_stop_ids_.data() + route_offsets_[id], route_stop_ids_.data() + route_offsets_[id + 1] }; 
+}
+
 } // namespace transport_catalogue
\ No newline at end of file
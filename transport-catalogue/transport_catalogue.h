@@ -1,9 +1,11 @@
 #pragma once
 
+#include "distance_table.h" 
 #include "domain.h" 
 #include "geo.h" 
 
 #include <algorithm>
+#include <chrono> 
 #include <deque> 
 #include <iostream> 
 #include <map> 
@@ -11,6 +13,7 @@
 #include <set> 
 #include <stdexcept> 
 #include <string> 
+#include <tuple> 
 #include <unordered_map> 
 #include <unordered_set> 
 #include <vector> 
@@ -21,37 +24,79 @@ using namespace domain;
 
 class TransportCatalogue {
 public:
-    class StopHasher { 
-    public: 
-        size_t operator()(std::pair<StopPtr, StopPtr> stop) const { 
-            return hasher_(stop.first) + 47 * hasher_(stop.second); 
-        } 
- 
-    private: 
-        std::hash<StopPtr> hasher_; 
-    };
-
     void AddStop(std::string_view stop_name, const geo::Coordinates coordinates);
     void AddRoute(std::string_view bus_name, const std::vector<StopPtr> stops, bool is_circle);
+    void AddRoutes(const std::vector<std::tuple<std::string_view, std::vector<StopPtr>, bool>>& routes);
     
     BusPtr GetRoute(const std::string_view& bus_name) const; 
     StopPtr GetStop(const std::string_view& stop_name) const;
     
+    // Бросает std::invalid_argument, если from или to равен nullptr
     void SetStopDistance(StopPtr from, StopPtr to, const int distance); 
     int GetStopDistance(StopPtr from, StopPtr to) const;
     
+    // Списки соседей остановок (GetNeighbours) построены, пока справочник завершён Finalize
+    const DistanceTable& GetStopDistances() const;
+    
     std::optional<BusStat> GetRouteStatistics(const std::string_view& bus_name) const;
     
+    // Завершает наполнение справочника: строит списки соседей остановок и считает
+    // статистику всех маршрутов, распределяя их по threads_count потокам.
+    // Любое последующее изменение справочника сбрасывает результат
+    void Finalize(size_t threads_count = 1);
+    // То же, но статистика маршрутов (по BusId) уже посчитана, например загружена из базы
+    void Finalize(std::vector<BusStat> bus_stats);
+    std::chrono::nanoseconds GetFinalizeDuration() const;
+    // Номер версии содержимого: растёт при каждом добавлении остановки, маршрута
+    // или расстояния. По нему сбрасываются кэши, построенные по справочнику
+    uint64_t GetVersion() const;
+    
     const std::map<std::string_view, BusPtr> SortBuses() const;
 
+    size_t GetStopCount() const;
+    size_t GetBusCount() const;
+    StopPtr GetStopById(StopId id) const;
+    BusPtr GetBusById(BusId id) const;
+
+    // Плоские массивы, индексируемые StopId/BusId
+    const std::vector<geo::Coordinates>& GetStopsCoordinates() const;
+    StopIdRange GetRouteStopIds(BusId id) const;
+
 private:
     std::deque<Stop> stops_; 
     std::deque<Bus> buses_; 
      
-    std::unordered_map<std::string_view, StopPtr> stopname_to_stop_; 
+    std::unordered_map<std::string_view, Stop*> stopname_to_stop_; 
     std::unordered_map<std::string_view, BusPtr> busname_to_bus_; 
  
-    std::unordered_map<std::pair<StopPtr, StopPtr>, int, StopHasher> stops_distances_;
+    DistanceTable stops_distances_;
+
+    // Структура массивов: координаты остановок подряд в памяти,
+    // остановки маршрутов в формате CSR (маршрут id занимает
+    // route_stop_ids_[route_offsets_[id], route_offsets_[id + 1]))
+    std::vector<geo::Coordinates> stop_coordinates_;
+    // Координаты с синусом и косинусом широты для длин маршрутов в Finalize
+    std::vector<geo::SpherePoint> stop_points_;
+    std::vector<StopId> route_stop_ids_;
+    std::vector<uint32_t> route_offsets_{ 0 };
+
+    std::vector<BusStat> bus_stats_;
+    bool is_finalized_ = false;
+    std::chrono::nanoseconds finalize_duration_{ 0 };
+    uint64_t version_ = 0;
+
+    BusPtr PushRoute(std::string_view bus_name, const std::vector<StopPtr>& stops, bool is_circle);
+    // Рабочие массивы ComputeRouteStatistics; в Finalize у каждого потока свои,
+    // чтобы не выделять память заново на каждый маршрут
+    struct StatisticsBuffers {
+        std::vector<StopId> unique_stops;
+        std::vector<double> segments;
+    };
+    BusStat ComputeRouteStatistics(BusPtr bus, StatisticsBuffers& buffers) const;
+    // Строит списки соседей остановок; сбрасывается при добавлении расстояний
+    void BuildStopAdjacency();
+    // Вызывается при каждом изменении: сбрасывает итоги Finalize и увеличивает версию
+    void ResetFinalized();
 };
 
 } // namespace transport_catalogue
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace transport_router {
+
+TransportRouter::TransportRouter(const TransportCatalogue& db, const RoutingSettings& settings)
+    : db_(db)
+    , settings_(settings)
+    , graph_(db.GetStopCount() * 2)
+    , router_(graph_) {
+    for (StopId id = 0; id < db_.GetStopCount(); ++id) {
+        graph_.AddEdge({ ArrivalVertex(id), BoardingVertex(id), static_cast<double>(settings_.bus_wait_time) });
+        edges_info_.push_back({ RouteItem::Type::WAIT, id, 0 });
+    }
+
+    for (BusId id = 0; id < db_.GetBusCount(); ++id) {
+        const StopIdRange route = db_.GetRouteStopIds(id);
+        std::vector<StopId> stops(route.begin(), route.end());
+        AddRideEdges(id, stops);
+        if (db_.GetBusById(id)->type == RouteType::Straight) {
+            std::reverse(stops.begin(), stops.end());
+            AddRideEdges(id, stops);
+        }
+    }
+}
+
+std::optional<RouteInfo> TransportRouter::FindRoute(std::string_view from, std::string_view to) const {
+    StopPtr from_stop = db_.GetStop(from);
+    StopPtr to_stop = db_.GetStop(to);
+    if (!from_stop || !to_stop) {
+        return std::nullopt;
+    }
+
+    const auto route = router_.BuildRoute(ArrivalVertex(from_stop->id), ArrivalVertex(to_stop->id));
+    if (!route) {
+        return std::nullopt;
+    }
+
+    RouteInfo result;
+    result.total_time = route->weight;
+    result.items.reserve(route->edges.size());
+    for (const graph::EdgeId edge_id : route->edges) {
+        const EdgeInfo& info = edges_info_[edge_id];
+        const double time = graph_.GetEdge(edge_id).weight;
+        if (info.type == RouteItem::Type::WAIT) {
+            result.items.push_back({ info.type, db_.GetStopById(info.id)->name, 0, time });
+        }
+        else {
+            result.items.push_back({ info.type, db_.GetBusById(info.id)->name, info.span_count, time });
+        }
+    }
+    return result;
+}
+
+void TransportRouter::BuildLandmarks(size_t threads_count) {
+    const std::vector<StopId> served = GetServedStops();
+    if (served.empty() || settings_.landmark_count <= 0) {
+        return;
+    }
+
+    const auto& coordinates = db_.GetStopsCoordinates();
+    geo::Coordinates center{ 0.0, 0.0 };
+    for (const StopId id : served) {
+        center.lat += coordinates[id].lat;
+        center.lng += coordinates[id].lng;
+    }
+    center.lat /= served.size();
+    center.lng /= served.size();
+
+    const size_t sector_count = static_cast<size_t>(settings_.landmark_count);
+    std::vector<std::optional<StopId>> farthest(sector_count);
+    std::vector<double> farthest_distance(sector_count, -1.0);
+    for (const StopId id : served) {
+        const double dy = coordinates[id].lat - center.lat;
+        const double dx = coordinates[id].lng - center.lng;
+        const double angle = std::atan2(dy, dx) + M_PI;
+        const size_t sector = std::min(sector_count - 1, static_cast<size_t>(angle / (2 * M_PI) * sector_count));
+        const double distance = dx * dx + dy * dy;
+        if (distance > farthest_distance[sector]) {
+            farthest_distance[sector] = distance;
+            farthest[sector] = id;
+        }
+    }
+
+    std::vector<graph::VertexId> landmarks;
+    for (const auto& id : farthest) {
+        if (id) {
+            landmarks.push_back(ArrivalVertex(*id));
+        }
+    }
+    router_.BuildLandmarks(std::move(landmarks), threads_count);
+}
+
+void TransportRouter::SetLandmarks(graph::LandmarkTable<double> landmarks) {
+    router_.SetLandmarks(std::move(landmarks));
+}
+
+const graph::LandmarkTable<double>& TransportRouter::GetLandmarks() const {
+    return router_.GetLandmarks();
+}
+
+bool TransportRouter::CheckLandmarks(size_t sample_count) const {
+    const std::vector<StopId> served = GetServedStops();
+    if (served.empty()) {
+        return true;
+    }
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<size_t> pick(0, served.size() - 1);
+    for (size_t i = 0; i < sample_count; ++i) {
+        const graph::VertexId from = ArrivalVertex(served[pick(generator)]);
+        const graph::VertexId to = ArrivalVertex(served[pick(generator)]);
+        const auto fast = router_.BuildRoute(from, to);
+        const auto baseline = router_.BuildRouteWithoutLandmarks(from, to);
+        if (fast.has_value() != baseline.has_value()) {
+            return false;
+        }
+        // Пути с равным временем могут отличаться порядком сложения весов
+        if (fast && std::abs(fast->weight - baseline->weight) > 1e-9 * std::max(1.0, baseline->weight)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const RoutingSettings& TransportRouter::GetSettings() const {
+    return settings_;
+}
+
+graph::VertexId TransportRouter::ArrivalVertex(StopId id) {
+    return static_cast<graph::VertexId>(id) * 2;
+}
+
+graph::VertexId TransportRouter::BoardingVertex(StopId id) {
+    return static_cast<graph::VertexId>(id) * 2 + 1;
+}
+
+std::vector<StopId> TransportRouter::GetServedStops() const {
+    std::vector<StopId> result;
+    for (StopId id = 0; id < db_.GetStopCount(); ++id) {
+        if (!db_.GetStopById(id)->buses_by_stop.empty()) {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
+
+void TransportRouter::AddRideEdges(BusId bus, const std::vector<StopId>& stops) {
+    const DistanceTable& distances = db_.GetStopDistances();
+    // Скорость в метрах в минуту
+    const double velocity = settings_.bus_velocity * 1000.0 / 60.0;
+    for (size_t i = 0; i + 1 < stops.size(); ++i) {
+        int distance = 0;
+        for (size_t j = i + 1; j < stops.size(); ++j) {
+            distance += distances.Get(stops[j - 1], stops[j]);
+            graph_.AddEdge({ BoardingVertex(stops[i]), ArrivalVertex(stops[j]), distance / velocity });
+            edges_info_.push_back({ RouteItem::Type::BUS, bus, static_cast<int>(j - i) });
+        }
+    }
+}
+
+} // namespace transport_router
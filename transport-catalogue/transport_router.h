@@ -0,0 +1,94 @@
+#pragma once
+
+#include "domain.h"
+#include "graph.h"
+#include "router.h"
+#include "transport_catalogue.h"
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace transport_router {
+
+using namespace transport_catalogue;
+using namespace domain;
+
+struct RoutingSettings {
+    // Время ожидания автобуса на остановке, минуты
+    int bus_wait_time = 0;
+    // Скорость автобуса, км/ч
+    double bus_velocity = 0.0;
+    // Количество ориентиров для ускорения поиска; 0 — обычный алгоритм Дейкстры
+    int landmark_count = 0;
+};
+
+struct RouteItem {
+    enum class Type {
+        WAIT,
+        BUS,
+    };
+
+    Type type;
+    // Остановка для WAIT, маршрут для BUS
+    std::string_view name;
+    int span_count = 0;
+    // Минуты
+    double time = 0.0;
+};
+
+struct RouteInfo {
+    double total_time = 0.0;
+    std::vector<RouteItem> items;
+};
+
+/*
+ * Маршрутизатор по справочнику. Каждой остановке соответствуют две вершины:
+ * "прибытие" и "посадка". Ребро прибытие -> посадка — ожидание автобуса,
+ * рёбра посадка -> прибытие — поездка на одном автобусе без пересадок через
+ * span_count перегонов. Граф строится один раз в конструкторе;
+ * справочник должен быть заполнен и жить дольше маршрутизатора
+ */
+class TransportRouter {
+public:
+    TransportRouter(const TransportCatalogue& db, const RoutingSettings& settings);
+    TransportRouter(const TransportRouter&) = delete;
+    TransportRouter& operator=(const TransportRouter&) = delete;
+
+    std::optional<RouteInfo> FindRoute(std::string_view from, std::string_view to) const;
+
+    // Выбирает settings.landmark_count ориентиров среди остановок с маршрутами
+    // (самые удалённые от центра в равных угловых секторах) и строит для них
+    // таблицы расстояний в threads_count потоков
+    void BuildLandmarks(size_t threads_count = 1);
+    void SetLandmarks(graph::LandmarkTable<double> landmarks);
+    const graph::LandmarkTable<double>& GetLandmarks() const;
+    // Сравнивает ускоренный поиск с обычным на sample_count парах остановок.
+    // Возвращает false, если хотя бы одно время в пути не совпало
+    bool CheckLandmarks(size_t sample_count) const;
+
+    const RoutingSettings& GetSettings() const;
+
+private:
+    struct EdgeInfo {
+        // BUS для поездки, WAIT для ожидания
+        RouteItem::Type type;
+        // BusId для поездки, StopId для ожидания
+        uint32_t id;
+        int span_count;
+    };
+
+    static graph::VertexId ArrivalVertex(StopId id);
+    static graph::VertexId BoardingVertex(StopId id);
+
+    void AddRideEdges(BusId bus, const std::vector<StopId>& stops);
+    std::vector<StopId> GetServedStops() const;
+
+    const TransportCatalogue& db_;
+    const RoutingSettings settings_;
+    graph::DirectedWeightedGraph<double> graph_;
+    std::vector<EdgeInfo> edges_info_;
+    graph::Router<double> router_;
+};
+
+} // namespace transport_router